@@ -27,7 +27,7 @@ int main() {
 
         std::cout << "key_ver=" << env.key_ver << '\n';
         std::cout << "seq=" << env.env.seq << '\n';
-        std::cout << "dev=" << out.dev << '\n';
+        std::cout << "dev=" << out.dev.str() << '\n';
         std::cout << "body=" << std::string(out.body.begin(), out.body.end()) << '\n';
         return 0;
     } catch (const std::exception& ex) {
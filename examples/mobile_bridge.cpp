@@ -1,4 +1,4 @@
-#include "syncstream/middleware.hpp"
+#include "syncstream/schema.hpp"
 
 #include <array>
 #include <chrono>
@@ -8,29 +8,25 @@
 #include <string>
 #include <vector>
 
-std::vector<std::uint8_t> bytes_of(const std::string& s) {
-    return std::vector<std::uint8_t>(s.begin(), s.end());
-}
-
 int main() {
     try {
         const auto key = syncstream::mint_key();
         syncstream::RelayCore phone_side(key, std::chrono::seconds(45));
         syncstream::RelayCore relay_side(key, std::chrono::seconds(45));
 
-        syncstream::Ctrl ctrl{};
-        ctrl.dev = "android-cam-a";
-        ctrl.cmd = syncstream::Cmd::sync;
-        ctrl.at_ms = syncstream::now_ms();
-        ctrl.body = bytes_of("start:1080p:30fps");
+        relay_side.strict_bodies(true);
+
+        const syncstream::SyncBody cfg{syncstream::Res::p1080, 30, 4000, 60, false, true};
+        const auto ctrl = syncstream::make_ctrl<syncstream::Cmd::sync>("android-cam-a", syncstream::now_ms(), cfg);
 
         const auto env = phone_side.seal_ctrl(ctrl);
         const auto out = relay_side.open_ctrl(env);
 
         std::cout << "seq=" << env.seq << '\n';
-        std::cout << "device=" << out.dev << '\n';
+        std::cout << "device=" << out.dev.str() << '\n';
         std::cout << "cmd=" << static_cast<int>(out.cmd) << '\n';
-        std::cout << "payload=" << std::string(out.body.begin(), out.body.end()) << '\n';
+        const auto got = syncstream::body_as<syncstream::Cmd::sync>(out);
+        std::cout << "payload=res:" << static_cast<int>(got.res) << " fps:" << static_cast<int>(got.fps) << " bytes:" << out.body.size() << '\n';
         return 0;
     } catch (const std::exception& ex) {
         std::cerr << ex.what() << '\n';
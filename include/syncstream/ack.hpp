@@ -0,0 +1,128 @@
+#pragma once
+
+#include "syncstream/edge_hub.hpp"
+#include "syncstream/schema.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace syncstream {
+
+inline constexpr std::size_t sack_bits = 64;
+
+struct Ack {
+    std::uint32_t key_ver;
+    std::uint64_t cum;
+    std::uint64_t top;
+    std::uint64_t sack;
+
+    bool covers(std::uint64_t seq) const;
+    bool abandons(std::uint64_t seq) const;
+};
+
+template <>
+struct BodyLayout<Ack> {
+    static constexpr auto fields = std::make_tuple(&Ack::key_ver, &Ack::cum, &Ack::top, &Ack::sack);
+    static constexpr bool ok(const Ack& a) {
+        if (a.top == a.cum) {
+            return a.sack == 0;
+        }
+        if (a.top < a.cum) {
+            return false;
+        }
+        const auto gap = a.top - 1 - a.cum;
+        return gap != 0 && (gap >= sack_bits || (a.sack >> gap) == 0) && (gap - 1 >= sack_bits || ((a.sack >> (gap - 1)) & 1U) == 0);
+    }
+};
+
+Body pack_ack(const Ack& ack);
+Ack unpack_ack(std::span<const std::uint8_t> body);
+
+class AckWindow {
+public:
+    AckWindow(std::chrono::milliseconds every, std::size_t per);
+
+    void note(std::string_view dev, std::uint32_t key_ver, std::uint64_t seq, std::uint64_t now);
+    std::vector<Ctrl> due(std::uint64_t now);
+    std::optional<Ack> state(std::string_view dev, std::uint32_t key_ver) const;
+    std::size_t pending() const;
+
+private:
+    struct Track {
+        DevId dev;
+        Ack ack;
+        std::size_t pending = 0;
+        std::uint64_t gen = 0;
+        bool queued = false;
+        bool full = false;
+    };
+
+    struct Timer {
+        std::uint64_t at;
+        std::uint64_t gen;
+        std::string key;
+    };
+
+    static std::string key_of(std::string_view dev, std::uint32_t key_ver);
+    void flush(Track& t, std::uint64_t now, std::vector<Ctrl>& out);
+
+    std::uint64_t every_;
+    std::size_t per_;
+    std::unordered_map<std::string, Track> tracks_;
+    std::deque<Timer> timers_;
+    std::vector<std::string> full_;
+    mutable std::mutex mu_;
+};
+
+struct Retry {
+    DevId dev;
+    VersionedEnv env;
+};
+
+struct RetryPlan {
+    std::vector<Retry> resend;
+    std::vector<Retry> lost;
+};
+
+class RetryBook {
+public:
+    RetryBook(std::chrono::milliseconds rto, std::chrono::milliseconds life, std::chrono::milliseconds max_rto = std::chrono::seconds(8));
+
+    std::uint64_t next_seq(std::string_view dev, std::uint32_t key_ver);
+    void track(std::string_view dev, const VersionedEnv& env, std::uint64_t now);
+    std::size_t on_ack(std::string_view dev, const Ack& ack);
+    RetryPlan due(std::uint64_t now);
+    std::size_t inflight() const;
+
+private:
+    struct Entry {
+        Retry item;
+        std::uint64_t first;
+        std::uint64_t next;
+        std::uint64_t rto;
+    };
+
+    using Stream = std::pair<std::string, std::uint32_t>;
+
+    std::uint64_t rto_;
+    std::uint64_t life_;
+    std::uint64_t max_rto_;
+    std::map<Stream, std::uint64_t> seqs_;
+    std::map<std::tuple<std::string, std::uint32_t, std::uint64_t>, Entry> sent_;
+    std::vector<Retry> dropped_;
+    mutable std::mutex mu_;
+};
+
+}
@@ -0,0 +1,262 @@
+#pragma once
+
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace syncstream {
+
+class Executor {
+public:
+    virtual ~Executor() = default;
+    virtual void post(std::coroutine_handle<> h) = 0;
+
+    auto schedule() {
+        struct Hop {
+            Executor& ex;
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(std::coroutine_handle<> h) { ex.post(h); }
+            void await_resume() const noexcept {}
+        };
+        return Hop{*this};
+    }
+};
+
+class InlineExecutor final : public Executor {
+public:
+    void post(std::coroutine_handle<> h) override;
+};
+
+class PoolExecutor final : public Executor {
+public:
+    explicit PoolExecutor(std::size_t threads);
+    ~PoolExecutor() override;
+    PoolExecutor(const PoolExecutor&) = delete;
+    PoolExecutor& operator=(const PoolExecutor&) = delete;
+
+    void post(std::coroutine_handle<> h) override;
+
+private:
+    void run();
+
+    std::deque<std::coroutine_handle<>> q_;
+    std::vector<std::thread> workers_;
+    bool stop_ = false;
+    std::mutex mu_;
+    std::condition_variable cv_;
+};
+
+template <typename T>
+class Task;
+
+namespace detail {
+
+struct PromiseBase {
+    std::coroutine_handle<> next;
+    std::exception_ptr err;
+
+    std::suspend_always initial_suspend() noexcept { return {}; }
+
+    struct Final {
+        bool await_ready() const noexcept { return false; }
+        template <typename P>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<P> h) noexcept {
+            auto next = h.promise().next;
+            return next ? next : std::noop_coroutine();
+        }
+        void await_resume() const noexcept {}
+    };
+
+    Final final_suspend() noexcept { return {}; }
+    void unhandled_exception() { err = std::current_exception(); }
+};
+
+template <typename T>
+struct Promise : PromiseBase {
+    std::optional<T> value;
+
+    Task<T> get_return_object();
+    void return_value(T v) { value.emplace(std::move(v)); }
+    T result() {
+        if (err) {
+            std::rethrow_exception(err);
+        }
+        return std::move(*value);
+    }
+};
+
+template <>
+struct Promise<void> : PromiseBase {
+    Task<void> get_return_object();
+    void return_void() {}
+    void result() {
+        if (err) {
+            std::rethrow_exception(err);
+        }
+    }
+};
+
+}
+
+template <typename T = void>
+class [[nodiscard]] Task {
+public:
+    using promise_type = detail::Promise<T>;
+    using Handle = std::coroutine_handle<promise_type>;
+
+    explicit Task(Handle h) : h_(h) {}
+    Task(Task&& other) noexcept : h_(std::exchange(other.h_, {})) {}
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            if (h_) {
+                h_.destroy();
+            }
+            h_ = std::exchange(other.h_, {});
+        }
+        return *this;
+    }
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+    ~Task() {
+        if (h_) {
+            h_.destroy();
+        }
+    }
+
+    bool await_ready() const noexcept { return false; }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> cont) noexcept {
+        h_.promise().next = cont;
+        return h_;
+    }
+    T await_resume() { return h_.promise().result(); }
+
+private:
+    Handle h_;
+};
+
+namespace detail {
+
+template <typename T>
+Task<T> Promise<T>::get_return_object() {
+    return Task<T>{std::coroutine_handle<Promise<T>>::from_promise(*this)};
+}
+
+inline Task<void> Promise<void>::get_return_object() {
+    return Task<void>{std::coroutine_handle<Promise<void>>::from_promise(*this)};
+}
+
+struct Signal {
+    std::mutex mu;
+    std::condition_variable cv;
+    bool done = false;
+};
+
+struct Detached {
+    struct promise_type {
+        Detached get_return_object() noexcept { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept { std::terminate(); }
+    };
+};
+
+template <typename T, typename Out>
+Detached run_signalled(Task<T> task, std::shared_ptr<Signal> sig, std::shared_ptr<Out> out) {
+    try {
+        if constexpr (std::is_void_v<T>) {
+            co_await task;
+            out->value = true;
+        } else {
+            out->value.emplace(co_await task);
+        }
+    } catch (...) {
+        out->err = std::current_exception();
+    }
+    std::scoped_lock lock(sig->mu);
+    sig->done = true;
+    sig->cv.notify_all();
+}
+
+}
+
+template <typename T>
+T sync_wait(Task<T> task) {
+    struct Out {
+        std::conditional_t<std::is_void_v<T>, std::optional<bool>, std::optional<T>> value;
+        std::exception_ptr err;
+    };
+    auto sig = std::make_shared<detail::Signal>();
+    auto out = std::make_shared<Out>();
+    detail::run_signalled(std::move(task), sig, out);
+    {
+        std::unique_lock lock(sig->mu);
+        sig->cv.wait(lock, [&] { return sig->done; });
+    }
+    if (out->err) {
+        std::rethrow_exception(out->err);
+    }
+    if constexpr (!std::is_void_v<T>) {
+        return std::move(*out->value);
+    }
+}
+
+class AsyncMutex {
+public:
+    class Guard {
+    public:
+        explicit Guard(AsyncMutex* m) : m_(m) {}
+        Guard(Guard&& other) noexcept : m_(std::exchange(other.m_, nullptr)) {}
+        Guard& operator=(Guard&&) = delete;
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+        ~Guard() {
+            if (m_) {
+                m_->unlock();
+            }
+        }
+
+    private:
+        AsyncMutex* m_;
+    };
+
+    auto lock(Executor& ex) {
+        struct Acquire {
+            AsyncMutex& m;
+            Executor& ex;
+            bool await_ready() { return m.try_lock(); }
+            bool await_suspend(std::coroutine_handle<> h) { return m.park(h, ex); }
+            Guard await_resume() { return Guard(&m); }
+        };
+        return Acquire{*this, ex};
+    }
+
+    void lock();
+    bool try_lock();
+    void unlock();
+
+private:
+    struct Waiter {
+        std::coroutine_handle<> h;
+        Executor* ex;
+        bool* ready = nullptr;
+    };
+
+    bool park(std::coroutine_handle<> h, Executor& ex);
+
+    bool held_ = false;
+    std::deque<Waiter> waiters_;
+    std::mutex mu_;
+    std::condition_variable cv_;
+};
+
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "syncstream/middleware.hpp"
+#include "syncstream/schema.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace syncstream {
+
+struct Beat {
+    DevId dev;
+    std::uint64_t at_ms;
+};
+
+std::vector<Beat> unpack_beats(std::span<const std::uint8_t> body);
+
+class BeatBatch {
+public:
+    BeatBatch(DevId gateway, std::size_t max_beats);
+
+    bool add(std::string_view dev, std::uint64_t at_ms);
+    bool full() const;
+    std::size_t size() const { return beats_.size(); }
+    Ctrl take(std::uint64_t now);
+
+private:
+    static constexpr std::size_t max_bytes_ = 0xFFFFU;
+
+    DevId gateway_;
+    std::size_t max_;
+    std::size_t bytes_ = 2;
+    std::vector<Beat> beats_;
+    std::unordered_map<std::string, std::size_t> index_;
+};
+
+template <>
+struct BodyLayout<BeatBatch> {
+    static bool fits(std::span<const std::uint8_t> body);
+};
+
+}
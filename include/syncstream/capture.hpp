@@ -0,0 +1,52 @@
+#pragma once
+
+#include "syncstream/edge_hub.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace syncstream {
+
+struct CaptureRecord {
+    std::uint64_t recv_ms;
+    VersionedEnv env;
+};
+
+enum class Fault : std::uint8_t {
+    none = 0,
+    malformed,
+    unknown_key,
+    skew,
+    auth,
+    replay
+};
+
+const char* fault_name(Fault why);
+
+struct VerifyKey {
+    std::uint32_t ver;
+    std::array<std::uint8_t, key_len> key;
+    Suite suite = Suite::aes_gcm;
+};
+
+struct RecordFault {
+    std::uint64_t index;
+    std::uint64_t offset;
+    Fault why;
+};
+
+struct VerifyReport {
+    std::uint64_t total = 0;
+    std::uint64_t ok = 0;
+    std::array<std::uint64_t, 6> by_fault{};
+    std::vector<RecordFault> faults;
+};
+
+void append_record(std::vector<std::uint8_t>& out, const CaptureRecord& rec);
+VerifyReport verify_capture(std::span<const std::uint8_t> data, std::span<const VerifyKey> keys, std::chrono::milliseconds max_skew, std::size_t threads = 0);
+
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace syncstream {
+
+class Clock {
+public:
+    virtual ~Clock() = default;
+    virtual std::uint64_t now_ms() const = 0;
+};
+
+class WallClock final : public Clock {
+public:
+    std::uint64_t now_ms() const override;
+};
+
+class CoarseClock final : public Clock {
+public:
+    std::uint64_t now_ms() const override;
+};
+
+class TickClock final : public Clock {
+public:
+    explicit TickClock(std::chrono::milliseconds period = std::chrono::milliseconds(1));
+    ~TickClock() override;
+    TickClock(const TickClock&) = delete;
+    TickClock& operator=(const TickClock&) = delete;
+
+    std::uint64_t now_ms() const override;
+
+private:
+    std::atomic<std::uint64_t> now_;
+    std::mutex mu_;
+    std::condition_variable_any cv_;
+    std::jthread ticker_;
+};
+
+class MonoClock final : public Clock {
+public:
+    MonoClock();
+
+    std::uint64_t now_ms() const override;
+    void resync();
+
+private:
+    std::atomic<std::int64_t> lead_;
+};
+
+class ManualClock final : public Clock {
+public:
+    explicit ManualClock(std::uint64_t start = 0);
+
+    std::uint64_t now_ms() const override;
+    void set(std::uint64_t at);
+    void advance(std::chrono::milliseconds by);
+
+private:
+    std::atomic<std::uint64_t> now_;
+};
+
+// Wall-anchored at first use, then advances on the monotonic clock so NTP steps cannot move skew, replay or TTL windows.
+std::shared_ptr<const Clock> default_clock();
+
+}
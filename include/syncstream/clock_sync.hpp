@@ -0,0 +1,92 @@
+#pragma once
+
+#include "syncstream/middleware.hpp"
+#include "syncstream/schema.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace syncstream {
+
+struct Echo {
+    std::uint64_t probe_ms;
+    std::uint64_t recv_ms;
+};
+
+template <>
+struct BodyLayout<Echo> {
+    static constexpr auto fields = std::make_tuple(&Echo::probe_ms, &Echo::recv_ms);
+    static constexpr bool ok(const Echo& e) { return e.probe_ms != 0 && e.recv_ms != 0; }
+};
+
+Body pack_echo(const Echo& echo);
+std::optional<Echo> unpack_echo(std::span<const std::uint8_t> body);
+Ctrl answer_probe(const Ctrl& probe, std::uint64_t recv_ms, std::uint64_t send_ms);
+
+struct OffsetSample {
+    std::int64_t offset_ms;
+    std::int64_t rtt_ms;
+};
+
+std::optional<OffsetSample> sample_of(std::uint64_t t1, std::uint64_t t2, std::uint64_t t3, std::uint64_t t4);
+
+struct ClockEstimate {
+    std::int64_t offset_ms;
+    std::int64_t target_ms;
+    std::int64_t jitter_ms;
+    std::int64_t rtt_ms;
+    std::uint64_t margin_ms;
+    std::size_t samples;
+};
+
+class ClockTracker {
+public:
+    ClockTracker(std::chrono::milliseconds window, std::chrono::milliseconds reach, std::chrono::milliseconds floor = std::chrono::milliseconds(50),
+                 std::size_t depth = 8);
+
+    bool add(std::string_view dev, const OffsetSample& sample, std::uint64_t now);
+    std::optional<ClockEstimate> estimate(std::string_view dev) const;
+    std::uint64_t admit(std::string_view dev, Cmd cmd, std::span<const std::uint8_t> body, std::uint64_t at_ms, std::uint64_t now) const;
+    bool learn(std::string_view dev, Cmd cmd, std::span<const std::uint8_t> body, std::uint64_t at_ms, std::uint64_t now);
+    std::uint64_t window() const { return window_; }
+    std::uint64_t reach() const { return reach_; }
+    std::size_t size() const;
+
+private:
+    struct Track {
+        std::vector<OffsetSample> ring;
+        std::size_t next = 0;
+        std::int64_t applied = 0;
+        std::int64_t target = 0;
+        std::int64_t jitter = 0;
+        std::int64_t rtt = 0;
+        std::uint64_t changed = 0;
+    };
+
+    struct DevHash {
+        using is_transparent = void;
+        std::size_t operator()(std::string_view dev) const { return std::hash<std::string_view>{}(dev); }
+    };
+
+    std::optional<Echo> fresh_echo(Cmd cmd, std::span<const std::uint8_t> body, std::uint64_t now) const;
+    std::uint64_t margin(const Track& t) const;
+
+    std::uint64_t window_;
+    std::uint64_t reach_;
+    std::uint64_t floor_;
+    std::size_t depth_;
+    std::int64_t step_;
+    std::uint64_t hold_;
+    std::unordered_map<std::string, Track, DevHash, std::equal_to<>> tracks_;
+    mutable std::mutex mu_;
+};
+
+}
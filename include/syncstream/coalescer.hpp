@@ -0,0 +1,51 @@
+#pragma once
+
+#include "syncstream/middleware.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace syncstream {
+
+struct CoalesceStats {
+    std::uint64_t merged_sync = 0;
+    std::uint64_t merged_ping = 0;
+    std::uint64_t held = 0;
+    std::uint64_t passed = 0;
+};
+
+class Coalescer {
+public:
+    explicit Coalescer(std::chrono::milliseconds window);
+
+    void push(Ctrl ctrl, std::uint64_t now);
+    std::vector<Ctrl> drain(std::uint64_t now);
+    std::vector<Ctrl> flush();
+    std::size_t pending() const;
+    CoalesceStats stats() const;
+
+private:
+    struct Held {
+        Ctrl ctrl;
+        std::uint64_t due;
+        std::string key;
+    };
+
+    void pop_front(std::vector<Ctrl>& out);
+
+    std::uint64_t window_;
+    std::deque<Held> held_;
+    std::uint64_t base_ = 0;
+    std::unordered_map<std::string, std::uint64_t> index_;
+    std::vector<Ctrl> ready_;
+    CoalesceStats stats_;
+    mutable std::mutex mu_;
+};
+
+}
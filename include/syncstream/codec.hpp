@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace syncstream {
+
+constexpr std::size_t hex_len(std::size_t n) {
+    return n * 2;
+}
+
+constexpr std::size_t b64_len(std::size_t n) {
+    return (n + 2) / 3 * 4;
+}
+
+std::size_t hex_encode(std::span<const std::uint8_t> in, std::span<char> out);
+std::size_t hex_decode(std::string_view in, std::span<std::uint8_t> out);
+std::size_t b64_encode(std::span<const std::uint8_t> in, std::span<char> out);
+std::size_t b64_decode(std::string_view in, std::span<std::uint8_t> out);
+
+std::string b64_of(std::span<const std::uint8_t> data);
+std::vector<std::uint8_t> from_b64(std::string_view text);
+const char* codec_path();
+
+}
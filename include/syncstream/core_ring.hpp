@@ -0,0 +1,52 @@
+#pragma once
+
+#include "syncstream/keychain.hpp"
+#include "syncstream/middleware.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+
+namespace syncstream {
+
+class CoreRing {
+public:
+    using Build = std::function<std::shared_ptr<RelayCore>(const std::array<std::uint8_t, key_len>& key, Suite suite)>;
+
+    CoreRing(Keychain& keys, std::chrono::milliseconds overlap, Build build);
+
+    void stage(std::uint32_t ver, Suite suite, std::shared_ptr<RelayCore> core = nullptr);
+    void activate(std::uint32_t ver, std::uint64_t now);
+    std::shared_ptr<RelayCore> core_for(std::uint32_t ver, std::uint64_t now);
+    std::size_t reap(std::uint64_t now);
+    std::size_t size() const { return slots_.size(); }
+    std::size_t built() const;
+
+    template <typename Fn>
+    void each(Fn&& fn) const {
+        for (const auto& kv : slots_) {
+            if (kv.second.core) {
+                fn(*kv.second.core);
+            }
+        }
+    }
+
+private:
+    struct Slot {
+        Suite suite;
+        std::shared_ptr<RelayCore> core;
+        std::uint64_t retire_at = 0;
+    };
+
+    Keychain& keys_;
+    std::uint64_t overlap_;
+    Build build_;
+    std::unordered_map<std::uint32_t, Slot> slots_;
+    std::uint32_t live_ = 0;
+};
+
+}
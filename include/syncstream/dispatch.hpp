@@ -0,0 +1,86 @@
+#pragma once
+
+#include "syncstream/middleware.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <optional>
+
+namespace syncstream {
+
+enum class Prio : std::uint8_t {
+    critical = 0,
+    normal = 1,
+    bulk = 2
+};
+
+inline constexpr std::size_t prio_count = 3;
+
+enum class Shed : std::uint8_t {
+    none = 0,
+    queue_full = 1,
+    delay = 2,
+    stale = 3
+};
+
+Prio prio_of(Cmd cmd);
+const char* shed_name(Shed why);
+
+struct ClassStats {
+    std::uint64_t admitted = 0;
+    std::uint64_t served = 0;
+    std::uint64_t shed_full = 0;
+    std::uint64_t shed_delay = 0;
+    std::uint64_t shed_stale = 0;
+    std::uint64_t max_wait_ms = 0;
+};
+
+struct DispatchConfig {
+    std::size_t depth = 4096;
+    std::chrono::milliseconds target{5};
+    std::chrono::milliseconds interval{100};
+    bool strict = true;
+    std::array<std::uint32_t, prio_count> weights{1, 4, 1};
+};
+
+class Dispatcher {
+public:
+    explicit Dispatcher(DispatchConfig cfg = {});
+
+    Shed push(Ctrl ctrl, std::uint64_t now);
+    std::optional<Ctrl> pop(std::uint64_t now);
+    std::size_t depth(Prio prio) const;
+    bool dropping(Prio prio) const;
+    ClassStats stats(Prio prio) const;
+
+private:
+    struct Item {
+        Ctrl ctrl;
+        std::uint64_t enq;
+    };
+
+    struct Lane {
+        std::deque<Item> q;
+        std::uint64_t first_above = 0;
+        std::uint64_t drop_next = 0;
+        std::uint32_t count = 0;
+        bool dropping = false;
+        std::uint32_t credit = 0;
+        ClassStats stats;
+    };
+
+    bool over_target(Lane& lane, std::uint64_t sojourn, std::uint64_t now);
+    std::optional<Ctrl> take(Lane& lane, std::uint64_t now);
+    std::size_t pick();
+
+    DispatchConfig cfg_;
+    std::array<Lane, prio_count> lanes_;
+    std::size_t turn_ = 1;
+    mutable std::mutex mu_;
+};
+
+}
@@ -1,15 +1,25 @@
 #pragma once
 
+#include "syncstream/async.hpp"
+#include "syncstream/beats.hpp"
+#include "syncstream/coalescer.hpp"
+#include "syncstream/core_ring.hpp"
 #include "syncstream/keychain.hpp"
 #include "syncstream/middleware.hpp"
+#include "syncstream/presence.hpp"
 
+#include <atomic>
 #include <chrono>
 #include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 namespace syncstream {
 
@@ -20,8 +30,11 @@ struct VersionedEnv {
 
 class RateGate {
 public:
-    RateGate(std::size_t burst, std::size_t refill_per_sec);
-    bool hit(const std::string& dev, std::uint64_t now);
+    RateGate(std::size_t burst, std::size_t refill_per_sec, std::chrono::milliseconds idle = std::chrono::minutes(1));
+    bool hit(std::string_view dev, std::uint64_t now);
+    Task<bool> hit_async(std::string dev, std::uint64_t now, Executor& ex);
+    bool knows(std::string_view dev) const;
+    std::size_t size() const;
 
 private:
     struct Bucket {
@@ -29,10 +42,20 @@ private:
         std::uint64_t last;
     };
 
+    struct DevHash {
+        using is_transparent = void;
+        std::size_t operator()(std::string_view dev) const { return std::hash<std::string_view>{}(dev); }
+    };
+
+    bool charge(std::string_view dev, std::uint64_t now);
+    void sweep(std::uint64_t now);
+
     std::size_t burst_;
     std::size_t refill_;
-    std::unordered_map<std::string, Bucket> slots_;
-    std::mutex mu_;
+    std::uint64_t idle_;
+    std::uint64_t next_sweep_ = 0;
+    std::unordered_map<std::string, Bucket, DevHash, std::equal_to<>> slots_;
+    mutable AsyncMutex mu_;
 };
 
 class PolicyGate {
@@ -46,24 +69,55 @@ private:
 
 class EdgeHub {
 public:
-    EdgeHub(std::array<std::uint8_t, key_len> master, std::chrono::milliseconds max_skew, std::size_t replay_cap, std::size_t burst, std::size_t refill_per_sec);
+    EdgeHub(std::array<std::uint8_t, key_len> master, std::chrono::milliseconds max_skew, std::size_t replay_hint, std::size_t burst, std::size_t refill_per_sec,
+            std::chrono::milliseconds overlap = std::chrono::seconds(30), std::shared_ptr<const Clock> clock = default_clock());
 
-    void stage_key(std::uint32_t ver, std::span<const std::uint8_t> salt, std::span<const std::uint8_t> ctx, bool activate_now);
+    void stage_key(std::uint32_t ver, std::span<const std::uint8_t> salt, std::span<const std::uint8_t> ctx, bool activate_now, Suite suite = Suite::aes_gcm);
+    void activate_key(std::uint32_t ver);
+    std::size_t retire_due();
+    std::size_t live_versions() const;
     void allow_cmd(Cmd cmd);
+    void track_clocks(std::shared_ptr<ClockTracker> clocks);
+    void strict_bodies(bool on);
+    void track_presence(std::shared_ptr<PresenceTable> presence);
 
     VersionedEnv seal(const Ctrl& ctrl);
     Ctrl open(const VersionedEnv& env);
+    std::optional<std::uint64_t> last_seen(std::string_view dev) const;
+
+    void coalesce(std::chrono::milliseconds window);
+    void submit(const VersionedEnv& env);
+    std::vector<Ctrl> drain();
+    CoalesceStats coalesce_stats() const;
+
+    Task<VersionedEnv> seal_async(Ctrl ctrl, Executor& ex);
+    Task<Ctrl> open_async(VersionedEnv env, Executor& ex);
+    Task<> stage_key_async(std::uint32_t ver, std::vector<std::uint8_t> salt, std::vector<std::uint8_t> ctx, bool activate_now, Executor& ex,
+                           Suite suite = Suite::aes_gcm);
+    Task<std::vector<Ctrl>> drain_async(Executor& ex);
 
 private:
-    RelayCore& core_for(std::uint32_t ver);
+    Ctrl open_at(const VersionedEnv& env, std::uint64_t now);
+    std::shared_ptr<RelayCore> core_for(std::uint32_t ver, std::uint64_t now);
+    Task<std::shared_ptr<RelayCore>> core_for_async(std::uint32_t ver, std::uint64_t now, Executor& ex);
+    void feed(const Ctrl& ctrl, std::uint64_t now);
+    std::shared_ptr<RelayCore> build(const std::array<std::uint8_t, key_len>& key, Suite suite) const;
+    std::size_t fan_out(const Ctrl& batch, std::uint64_t now);
+    std::shared_ptr<Coalescer> coalescer() const;
 
     Keychain keychain_;
+    std::shared_ptr<const Clock> clock_;
     std::chrono::milliseconds max_skew_;
-    std::size_t replay_cap_;
+    std::size_t replay_hint_;
     RateGate rate_;
     PolicyGate policy_;
-    std::unordered_map<std::uint32_t, std::unique_ptr<RelayCore>> cores_;
-    std::mutex mu_;
+    std::shared_ptr<ClockTracker> clocks_;
+    std::atomic<std::shared_ptr<PresenceTable>> presence_;
+    bool strict_ = false;
+    CoreRing ring_;
+    std::shared_ptr<Coalescer> coal_;
+    AsyncMutex flush_gate_;
+    mutable AsyncMutex mu_;
 };
 
 }
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <cstring>
+#include <initializer_list>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace syncstream {
+
+template <typename T, std::size_t N>
+class InlineBuf {
+    static_assert(std::is_trivially_copyable_v<T>, "inline buffer holds trivial values only");
+
+public:
+    InlineBuf() = default;
+    InlineBuf(std::initializer_list<T> init) { assign(init.begin(), init.size()); }
+    InlineBuf(std::span<const T> data) { assign(data.data(), data.size()); }
+    InlineBuf(const std::vector<T>& data) { assign(data.data(), data.size()); }
+    InlineBuf(const char* text)
+        requires std::same_as<T, char>
+    {
+        const std::string_view sv(text);
+        assign(sv.data(), sv.size());
+    }
+    InlineBuf(std::string_view text)
+        requires std::same_as<T, char>
+    {
+        assign(text.data(), text.size());
+    }
+    InlineBuf(const std::string& text)
+        requires std::same_as<T, char>
+    {
+        assign(text.data(), text.size());
+    }
+
+    InlineBuf(const InlineBuf& other) { assign(other.data(), other.size()); }
+
+    InlineBuf(InlineBuf&& other) noexcept { steal(other); }
+
+    InlineBuf& operator=(const InlineBuf& other) {
+        if (this != &other) {
+            assign(other.data(), other.size());
+        }
+        return *this;
+    }
+
+    InlineBuf& operator=(InlineBuf&& other) noexcept {
+        if (this != &other) {
+            steal(other);
+        }
+        return *this;
+    }
+
+    ~InlineBuf() = default;
+
+    T* data() { return heap_ ? heap_.get() : local_.data(); }
+    const T* data() const { return heap_ ? heap_.get() : local_.data(); }
+    std::size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    bool local() const { return !heap_; }
+
+    T* begin() { return data(); }
+    T* end() { return data() + size_; }
+    const T* begin() const { return data(); }
+    const T* end() const { return data() + size_; }
+
+    T& operator[](std::size_t i) { return data()[i]; }
+    const T& operator[](std::size_t i) const { return data()[i]; }
+
+    std::span<const T> view() const { return {data(), size_}; }
+
+    std::string_view str() const
+        requires std::same_as<T, char>
+    {
+        return {data(), size_};
+    }
+
+    void resize(std::size_t n) {
+        if (n > N && (!heap_ || n > cap_)) {
+            auto grown = std::make_unique<T[]>(n);
+            std::copy_n(data(), std::min(size_, n), grown.get());
+            heap_ = std::move(grown);
+            cap_ = n;
+        }
+        if (n > size_) {
+            std::fill(data() + size_, data() + n, T{});
+        }
+        size_ = n;
+    }
+
+    friend bool operator==(const InlineBuf& a, const InlineBuf& b) { return std::ranges::equal(a.view(), b.view()); }
+
+private:
+    void assign(const T* src, std::size_t n) {
+        if (n > N && (!heap_ || n > cap_)) {
+            auto grown = std::make_unique<T[]>(n);
+            std::copy_n(src, n, grown.get());
+            heap_ = std::move(grown);
+            cap_ = n;
+        } else if (n > N) {
+            std::memmove(heap_.get(), src, n * sizeof(T));
+        } else {
+            if (n != 0) {
+                std::memmove(local_.data(), src, n * sizeof(T));
+            }
+            heap_.reset();
+            cap_ = N;
+        }
+        size_ = n;
+    }
+
+    void steal(InlineBuf& other) {
+        if (other.heap_) {
+            heap_ = std::move(other.heap_);
+            cap_ = other.cap_;
+        } else {
+            heap_.reset();
+            cap_ = N;
+            std::copy_n(other.local_.data(), other.size_, local_.data());
+        }
+        size_ = other.size_;
+        other.size_ = 0;
+        other.cap_ = N;
+    }
+
+    std::array<T, N> local_{};
+    std::unique_ptr<T[]> heap_;
+    std::size_t size_ = 0;
+    std::size_t cap_ = N;
+};
+
+}
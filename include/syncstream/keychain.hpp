@@ -11,6 +11,8 @@
 
 namespace syncstream {
 
+void hkdf_sha256(std::span<const std::uint8_t> ikm, std::span<const std::uint8_t> salt, std::span<const std::uint8_t> info, std::span<std::uint8_t> out);
+
 class Keychain {
 public:
     explicit Keychain(std::array<std::uint8_t, key_len> master);
@@ -18,14 +20,24 @@ public:
     Keychain(const Keychain&) = delete;
     Keychain& operator=(const Keychain&) = delete;
 
-    void stage(std::uint32_t ver, std::span<const std::uint8_t> salt, std::span<const std::uint8_t> ctx);
+    SecureBlob derive(std::span<const std::uint8_t> salt, std::span<const std::uint8_t> ctx) const;
+    void stage(std::uint32_t ver, std::span<const std::uint8_t> salt, std::span<const std::uint8_t> ctx, Suite suite = Suite::aes_gcm);
+    void stage(std::uint32_t ver, SecureBlob key, Suite suite = Suite::aes_gcm);
     void activate(std::uint32_t ver);
+    void drop(std::uint32_t ver);
     std::array<std::uint8_t, key_len> take(std::uint32_t ver) const;
+    Suite suite(std::uint32_t ver) const;
+    bool has(std::uint32_t ver) const;
     std::uint32_t active() const;
 
 private:
-    std::array<std::uint8_t, key_len> master_{};
-    std::unordered_map<std::uint32_t, std::array<std::uint8_t, key_len>> slots_;
+    struct Slot {
+        SecureBlob key;
+        Suite suite;
+    };
+
+    SecureBlob master_;
+    std::unordered_map<std::uint32_t, Slot> slots_;
     std::uint32_t active_ = 0;
     mutable std::mutex mu_;
 };
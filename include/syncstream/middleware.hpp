@@ -1,14 +1,19 @@
 #pragma once
 
+#include "syncstream/async.hpp"
+#include "syncstream/clock.hpp"
+#include "syncstream/inline_buf.hpp"
+#include "syncstream/replay.hpp"
 #include "syncstream/secure_channel.hpp"
 
+#include <atomic>
 #include <chrono>
 #include <cstdint>
-#include <deque>
+#include <memory>
 #include <mutex>
 #include <span>
 #include <string>
-#include <unordered_set>
+#include <string_view>
 #include <vector>
 
 namespace syncstream {
@@ -17,16 +22,46 @@ enum class Cmd : std::uint8_t {
     arm = 1,
     disarm = 2,
     sync = 3,
-    ping = 4
+    ping = 4,
+    beats = 5,
+    ack = 6,
+    sync_delta = 7
 };
 
+inline constexpr std::size_t inline_len = 32;
+
+using DevId = InlineBuf<char, inline_len>;
+using Body = InlineBuf<std::uint8_t, inline_len>;
+
 struct Ctrl {
-    std::string dev;
+    DevId dev;
     Cmd cmd;
     std::uint64_t at_ms;
-    std::vector<std::uint8_t> body;
+    Body body;
+};
+
+class CtrlView {
+public:
+    std::string_view dev() const;
+    Cmd cmd() const { return cmd_; }
+    std::uint64_t at_ms() const { return at_ms_; }
+    std::span<const std::uint8_t> body() const;
+    Ctrl ctrl() const;
+
+private:
+    friend class RelayCore;
+
+    SecureBlob raw_;
+    std::size_t dev_at_ = 0;
+    std::size_t dev_len_ = 0;
+    std::size_t body_at_ = 0;
+    std::size_t body_len_ = 0;
+    Cmd cmd_{};
+    std::uint64_t at_ms_ = 0;
 };
 
+class ClockTracker;
+
 struct Env {
     std::uint64_t seq;
     std::uint64_t at_ms;
@@ -35,28 +70,40 @@ struct Env {
 
 class RelayCore {
 public:
-    RelayCore(std::array<std::uint8_t, key_len> key, std::chrono::milliseconds max_skew, std::size_t replay_cap = 8192);
+    RelayCore(std::array<std::uint8_t, key_len> key, std::chrono::milliseconds max_skew, std::size_t replay_hint = 8192,
+              std::shared_ptr<const Clock> clock = default_clock(), Suite suite = Suite::aes_gcm);
+    RelayCore(std::array<std::uint8_t, key_len> key, std::chrono::milliseconds max_skew, std::shared_ptr<ReplayStore> replay,
+              std::shared_ptr<const Clock> clock = default_clock(), Suite suite = Suite::aes_gcm);
 
     Env seal_ctrl(const Ctrl& ctrl);
+    Env seal_ctrl(const Ctrl& ctrl, std::uint64_t seq);
     Ctrl open_ctrl(const Env& env);
+    Ctrl open_ctrl(const Env& env, std::uint64_t now);
+    CtrlView open_view(const Env& env);
+    CtrlView open_view(const Env& env, std::uint64_t now);
+    Task<Ctrl> open_async(Env env, std::uint64_t now, Executor& ex);
+    std::size_t replay_size() const;
+    Suite suite() const { return rig_.suite(); }
+    void track_clocks(std::shared_ptr<ClockTracker> clocks);
+    void strict_bodies(bool on) { strict_.store(on, std::memory_order_release); }
 
 private:
     std::vector<std::uint8_t> pack_ctrl(const Ctrl& ctrl) const;
-    Ctrl unpack_ctrl(std::span<const std::uint8_t> raw) const;
-    std::vector<std::uint8_t> aad_for(std::uint64_t seq, std::uint64_t at_ms) const;
-
-    bool seen_or_mark(const std::string& k);
-    void trim();
+    CtrlView unpack_ctrl(SecureBlob raw) const;
+    CtrlView unseal(const Env& env, std::uint64_t now, const ClockTracker* clocks) const;
+    void mark(const Env& env, std::uint64_t at, std::uint64_t now);
 
     CipherRig rig_;
+    std::shared_ptr<const Clock> clock_;
     std::chrono::milliseconds max_skew_;
-    std::size_t replay_cap_;
-    std::uint64_t seq_ = 0;
-    std::unordered_set<std::string> seen_;
-    std::deque<std::string> fifo_;
-    std::mutex mu_;
+    std::atomic<std::uint64_t> seq_{0};
+    std::shared_ptr<ReplayStore> replay_;
+    std::atomic<std::shared_ptr<ClockTracker>> clocks_;
+    std::atomic<bool> strict_ = false;
+    mutable AsyncMutex mu_;
 };
 
 std::uint64_t now_ms();
+std::array<std::uint8_t, 16> env_aad(std::uint64_t seq, std::uint64_t at_ms);
 
 }
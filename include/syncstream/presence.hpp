@@ -0,0 +1,94 @@
+#pragma once
+
+#include "syncstream/middleware.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace syncstream {
+
+enum class Presence : std::uint8_t {
+    unknown = 0,
+    online = 1,
+    offline = 2
+};
+
+using PresenceFn = std::function<void(std::string_view dev, Presence state, std::uint64_t at_ms)>;
+
+class PresenceTable {
+public:
+    PresenceTable(std::size_t capacity, std::chrono::milliseconds timeout, std::chrono::milliseconds tick = std::chrono::milliseconds(100));
+
+    // Callbacks run one at a time under the notify lock, in transition order; they must not call subscribe, seen or advance.
+    void subscribe(PresenceFn fn);
+    std::optional<std::uint32_t> enroll(std::string_view dev);
+    std::optional<std::uint32_t> index_of(std::string_view dev) const;
+    bool seen(std::string_view dev, std::uint64_t at_ms);
+    std::size_t advance(std::uint64_t now);
+
+    Presence state(std::string_view dev) const;
+    Presence state_at(std::uint32_t idx) const { return static_cast<Presence>(slots_[idx].state.load(std::memory_order_acquire)); }
+    std::optional<std::uint64_t> last_seen(std::string_view dev) const;
+    std::string_view name_at(std::uint32_t idx) const { return names_[idx].str(); }
+    std::size_t size() const { return count_.load(std::memory_order_acquire); }
+    std::size_t online() const { return online_.load(std::memory_order_relaxed); }
+    std::size_t capacity() const { return slots_.size(); }
+
+private:
+    static constexpr std::size_t wheel_bits = 6;
+    static constexpr std::size_t wheel_size = std::size_t{1} << wheel_bits;
+    static constexpr std::size_t wheel_levels = 4;
+    static constexpr std::uint32_t none = 0xFFFFFFFFU;
+
+    struct alignas(16) Slot {
+        std::atomic<std::uint64_t> seen{0};
+        std::atomic<std::uint8_t> state{0};
+    };
+
+    struct Node {
+        std::uint32_t next = none;
+        std::uint32_t bucket = none;
+        std::uint64_t due = 0;
+    };
+
+    struct Change {
+        std::uint32_t idx;
+        Presence state;
+        std::uint64_t at_ms;
+    };
+
+    std::size_t probe_of(std::string_view dev) const;
+    void schedule(std::uint32_t idx, std::uint64_t due_ms);
+    void place(std::uint32_t idx, std::uint64_t floor);
+    void cascade(std::size_t level);
+    void notify(const std::vector<Change>& changes) const;
+
+    std::uint64_t timeout_;
+    std::uint64_t tick_;
+    std::vector<Slot> slots_;
+    std::vector<DevId> names_;
+    std::vector<std::atomic<std::uint32_t>> index_;
+    std::atomic<std::size_t> count_{0};
+    std::atomic<std::size_t> online_{0};
+    std::mutex enroll_mu_;
+
+    std::vector<Node> nodes_;
+    std::array<std::uint32_t, wheel_size * wheel_levels> heads_{};
+    std::uint64_t cur_ = 0;
+    bool started_ = false;
+    std::mutex wheel_mu_;
+    std::mutex notify_mu_;
+
+    std::vector<PresenceFn> subs_;
+};
+
+}
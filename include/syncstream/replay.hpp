@@ -0,0 +1,68 @@
+#pragma once
+
+#include "syncstream/secure_channel.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_set>
+#include <vector>
+
+namespace syncstream {
+
+struct ReplayKey {
+    std::array<std::uint8_t, 8 + nonce_len + tag_len> raw{};
+
+    static ReplayKey of(std::uint64_t seq, const Packet& pkt);
+    bool operator==(const ReplayKey&) const = default;
+};
+
+std::uint64_t replay_hash(const ReplayKey& key, std::uint64_t seed);
+std::uint64_t replay_span(std::chrono::milliseconds window);
+
+class ReplayStore {
+public:
+    virtual ~ReplayStore() = default;
+    virtual bool seen_or_mark(const ReplayKey& key, std::uint64_t at_ms, std::uint64_t now) = 0;
+    virtual std::size_t size(std::uint64_t now) const = 0;
+    virtual std::uint64_t window() const = 0;
+};
+
+class ReplayWheel final : public ReplayStore {
+public:
+    ReplayWheel(std::chrono::milliseconds window, std::size_t hint);
+
+    bool seen_or_mark(const ReplayKey& key, std::uint64_t at_ms, std::uint64_t now) override;
+    std::size_t size(std::uint64_t now) const override;
+    std::uint64_t window() const override { return window_; }
+    std::size_t sweep(std::uint64_t now);
+    std::size_t slots() const { return ring_.size(); }
+    std::uint64_t span() const { return span_; }
+
+private:
+    struct KeyHash {
+        std::uint64_t seed;
+        std::size_t operator()(const ReplayKey& key) const { return static_cast<std::size_t>(replay_hash(key, seed)); }
+    };
+
+    struct Bucket {
+        std::uint64_t epoch = 0;
+        bool used = false;
+        std::unordered_set<ReplayKey, KeyHash> keys;
+    };
+
+    bool expired(std::uint64_t epoch, std::uint64_t now) const;
+    bool holds(const ReplayKey& key, std::uint64_t epoch) const;
+    std::size_t drop(Bucket& bucket);
+
+    std::uint64_t window_;
+    std::uint64_t span_;
+    std::size_t fill_;
+    std::uint64_t seed_;
+    std::vector<Bucket> ring_;
+    std::uint64_t swept_ = 0;
+    std::size_t live_ = 0;
+};
+
+}
@@ -0,0 +1,255 @@
+#pragma once
+
+#include "syncstream/middleware.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace syncstream {
+
+enum class Res : std::uint8_t {
+    p480 = 1,
+    p720 = 2,
+    p1080 = 3,
+    p2160 = 4
+};
+
+struct ZoneBody {
+    std::uint32_t zones;
+
+    bool operator==(const ZoneBody&) const = default;
+};
+
+struct SyncBody {
+    Res res;
+    std::uint8_t fps;
+    std::uint32_t bitrate_kbps;
+    std::uint16_t gop;
+    bool night;
+    bool record;
+
+    bool operator==(const SyncBody&) const = default;
+};
+
+struct Ack;
+struct Echo;
+struct SyncDelta;
+class BeatBatch;
+
+template <typename T>
+struct BodyLayout;
+
+template <>
+struct BodyLayout<ZoneBody> {
+    static constexpr auto fields = std::make_tuple(&ZoneBody::zones);
+    static constexpr bool ok(const ZoneBody& b) { return b.zones != 0; }
+};
+
+template <>
+struct BodyLayout<SyncBody> {
+    static constexpr auto fields = std::make_tuple(&SyncBody::res, &SyncBody::fps, &SyncBody::bitrate_kbps, &SyncBody::gop, &SyncBody::night, &SyncBody::record);
+    static constexpr bool ok(const SyncBody& b) { return b.res >= Res::p480 && b.res <= Res::p2160 && b.fps != 0 && b.fps <= 120; }
+};
+
+template <Cmd C>
+struct CmdBody {
+    static constexpr bool typed = false;
+};
+
+template <>
+struct CmdBody<Cmd::arm> {
+    static constexpr bool typed = true;
+    using type = ZoneBody;
+};
+
+template <>
+struct CmdBody<Cmd::disarm> {
+    static constexpr bool typed = true;
+    using type = ZoneBody;
+};
+
+template <>
+struct CmdBody<Cmd::sync> {
+    static constexpr bool typed = true;
+    using type = SyncBody;
+};
+
+template <>
+struct CmdBody<Cmd::ping> {
+    static constexpr bool typed = true;
+    static constexpr bool empty_ok = true;
+    using type = Echo;
+};
+
+template <>
+struct CmdBody<Cmd::beats> {
+    static constexpr bool typed = true;
+    using type = BeatBatch;
+};
+
+template <>
+struct CmdBody<Cmd::ack> {
+    static constexpr bool typed = true;
+    using type = Ack;
+};
+
+template <>
+struct CmdBody<Cmd::sync_delta> {
+    static constexpr bool typed = true;
+    using type = SyncDelta;
+};
+
+template <Cmd C>
+using body_t = typename CmdBody<C>::type;
+
+template <Cmd... Cs>
+struct CmdList {};
+
+using TypedCmds = CmdList<Cmd::arm, Cmd::disarm, Cmd::sync, Cmd::ping, Cmd::beats, Cmd::ack, Cmd::sync_delta>;
+
+namespace detail {
+
+template <typename P>
+struct member_of;
+
+template <typename T, typename M>
+struct member_of<M T::*> {
+    using type = M;
+};
+
+template <typename M, bool = std::is_enum_v<M>>
+struct wire_uint {
+    using type = std::make_unsigned_t<M>;
+};
+
+template <typename M>
+struct wire_uint<M, true> {
+    using type = std::make_unsigned_t<std::underlying_type_t<M>>;
+};
+
+template <>
+struct wire_uint<bool, false> {
+    using type = std::uint8_t;
+};
+
+template <typename M>
+constexpr std::size_t wire_of() {
+    if constexpr (std::is_enum_v<M>) {
+        return sizeof(std::underlying_type_t<M>);
+    } else if constexpr (std::is_integral_v<M>) {
+        return sizeof(M);
+    } else {
+        static_assert(std::is_same_v<M, std::array<std::uint8_t, std::tuple_size_v<M>>>, "body field type not supported");
+        return std::tuple_size_v<M>;
+    }
+}
+
+template <typename M>
+constexpr void put_field(std::uint8_t* out, std::size_t& at, const M& v) {
+    if constexpr (std::is_enum_v<M> || std::is_integral_v<M>) {
+        using U = typename wire_uint<M>::type;
+        const auto u = static_cast<U>(v);
+        for (std::size_t i = 0; i < sizeof(U); ++i) {
+            out[at + i] = static_cast<std::uint8_t>((u >> ((sizeof(U) - 1 - i) * 8)) & 0xFFU);
+        }
+        at += sizeof(U);
+    } else {
+        for (std::size_t i = 0; i < v.size(); ++i) {
+            out[at + i] = v[i];
+        }
+        at += v.size();
+    }
+}
+
+template <typename M>
+constexpr bool get_field(std::span<const std::uint8_t> in, std::size_t& at, M& v) {
+    if constexpr (std::is_enum_v<M> || std::is_integral_v<M>) {
+        using U = typename wire_uint<M>::type;
+        U u = 0;
+        for (std::size_t i = 0; i < sizeof(U); ++i) {
+            u = static_cast<U>((u << 8) | in[at + i]);
+        }
+        at += sizeof(U);
+        if constexpr (std::is_same_v<M, bool>) {
+            if (u > 1) {
+                return false;
+            }
+            v = u == 1;
+        } else {
+            v = static_cast<M>(u);
+        }
+    } else {
+        for (std::size_t i = 0; i < v.size(); ++i) {
+            v[i] = in[at + i];
+        }
+        at += v.size();
+    }
+    return true;
+}
+
+}
+
+template <typename T>
+inline constexpr std::size_t wire_size_v = std::apply(
+    [](auto... f) { return (detail::wire_of<typename detail::member_of<decltype(f)>::type>() + ... + std::size_t{0}); }, BodyLayout<T>::fields);
+
+template <typename T>
+constexpr std::array<std::uint8_t, wire_size_v<T>> encode_body(const T& body) {
+    std::array<std::uint8_t, wire_size_v<T>> out{};
+    std::size_t at = 0;
+    std::apply([&](auto... f) { (detail::put_field(out.data(), at, body.*f), ...); }, BodyLayout<T>::fields);
+    return out;
+}
+
+template <typename T>
+constexpr bool try_decode_body(std::span<const std::uint8_t> in, T& body) {
+    if (in.size() != wire_size_v<T>) {
+        return false;
+    }
+    std::size_t at = 0;
+    const bool read = std::apply([&](auto... f) { return (detail::get_field(in, at, body.*f) && ...); }, BodyLayout<T>::fields);
+    return read && BodyLayout<T>::ok(body);
+}
+
+template <typename T>
+constexpr T decode_body(std::span<const std::uint8_t> in) {
+    T body{};
+    if (!try_decode_body(in, body)) {
+        throw std::runtime_error("body schema mismatch");
+    }
+    return body;
+}
+
+template <Cmd C>
+Ctrl make_ctrl(DevId dev, std::uint64_t at_ms, const body_t<C>& body) {
+    const auto raw = encode_body(body);
+    return Ctrl{std::move(dev), C, at_ms, Body(std::span<const std::uint8_t>(raw))};
+}
+
+template <Cmd C>
+body_t<C> body_as(Cmd cmd, std::span<const std::uint8_t> body) {
+    if (cmd != C) {
+        throw std::runtime_error("cmd mismatch");
+    }
+    return decode_body<body_t<C>>(body);
+}
+
+template <Cmd C>
+body_t<C> body_as(const Ctrl& ctrl) {
+    return body_as<C>(ctrl.cmd, ctrl.body.view());
+}
+
+template <Cmd C>
+body_t<C> body_as(const CtrlView& view) {
+    return body_as<C>(view.cmd(), view.body());
+}
+
+bool body_fits(Cmd cmd, std::span<const std::uint8_t> body);
+
+}
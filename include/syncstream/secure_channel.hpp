@@ -13,9 +13,15 @@ inline constexpr std::size_t key_len = 32;
 inline constexpr std::size_t nonce_len = 12;
 inline constexpr std::size_t tag_len = 16;
 
+enum class Suite : std::uint8_t {
+    aes_gcm = 1,
+    chacha_poly = 2
+};
+
 class SecureBlob {
 public:
     SecureBlob() = default;
+    explicit SecureBlob(std::size_t len);
     explicit SecureBlob(std::vector<std::uint8_t> data);
     SecureBlob(SecureBlob&& other) noexcept;
     SecureBlob& operator=(SecureBlob&& other) noexcept;
@@ -23,14 +29,22 @@ public:
     SecureBlob& operator=(const SecureBlob&) = delete;
     ~SecureBlob();
 
+    static SecureBlob copy_of(std::span<const std::uint8_t> data);
+
     std::span<const std::uint8_t> view() const;
+    std::span<std::uint8_t> bytes();
+    std::size_t size() const;
     std::vector<std::uint8_t> take();
 
 private:
-    std::vector<std::uint8_t> data_;
+    void release();
+
+    std::uint8_t* ptr_ = nullptr;
+    std::size_t len_ = 0;
 };
 
 struct Packet {
+    Suite suite = Suite::aes_gcm;
     std::array<std::uint8_t, nonce_len> nonce{};
     std::vector<std::uint8_t> body;
     std::array<std::uint8_t, tag_len> mac{};
@@ -38,7 +52,7 @@ struct Packet {
 
 class CipherRig {
 public:
-    explicit CipherRig(std::array<std::uint8_t, key_len> key);
+    explicit CipherRig(std::array<std::uint8_t, key_len> key, Suite suite = Suite::aes_gcm);
     CipherRig(const CipherRig&) = delete;
     CipherRig& operator=(const CipherRig&) = delete;
     CipherRig(CipherRig&&) = delete;
@@ -47,12 +61,17 @@ public:
 
     Packet seal(std::span<const std::uint8_t> plain, std::span<const std::uint8_t> aad) const;
     SecureBlob open(const Packet& pack, std::span<const std::uint8_t> aad) const;
+    Suite suite() const { return suite_; }
 
 private:
-    std::array<std::uint8_t, key_len> key_{};
+    SecureBlob key_;
+    Suite suite_;
 };
 
 std::array<std::uint8_t, key_len> mint_key();
+bool has_aes_hw();
+Suite pick_suite();
+const char* suite_name(Suite suite);
 std::string hex_of(std::span<const std::uint8_t> data);
 std::vector<std::uint8_t> from_hex(const std::string& text);
 
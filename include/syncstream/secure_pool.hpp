@@ -0,0 +1,62 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace syncstream {
+
+class SecurePool {
+public:
+    static constexpr std::size_t class_count = 8;
+    static constexpr std::size_t min_class = 32;
+    static constexpr std::size_t max_class = min_class << (class_count - 1);
+
+    struct Stats {
+        std::size_t slabs;
+        std::size_t large;
+        std::size_t in_use;
+        bool locked;
+    };
+
+    SecurePool();
+    ~SecurePool();
+    SecurePool(const SecurePool&) = delete;
+    SecurePool& operator=(const SecurePool&) = delete;
+
+    static SecurePool& global();
+
+    std::uint8_t* grab(std::size_t n);
+    void give(std::uint8_t* p, std::size_t n);
+    Stats stats() const;
+
+private:
+    struct Span {
+        std::uint8_t* base;
+        std::size_t len;
+    };
+
+    struct Tier {
+        std::vector<std::uint8_t*> free;
+        std::vector<Span> slabs;
+        std::size_t in_use = 0;
+        mutable std::mutex mu;
+    };
+
+    static std::size_t tier_of(std::size_t n);
+    Span map_guarded(std::size_t n);
+    void unmap_guarded(Span span);
+    void grow(Tier& tier, std::size_t block);
+
+    std::size_t page_;
+    std::array<Tier, class_count> tiers_;
+    std::unordered_map<std::uint8_t*, Span> large_;
+    mutable std::mutex large_mu_;
+    std::atomic<bool> locked_{true};
+};
+
+}
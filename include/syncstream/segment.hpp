@@ -0,0 +1,57 @@
+#pragma once
+
+#include "syncstream/secure_channel.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace syncstream {
+
+inline constexpr std::size_t digest_len = 32;
+using Digest = std::array<std::uint8_t, digest_len>;
+using ChunkList = std::span<const std::span<const std::uint8_t>>;
+
+Digest leaf_hash(std::span<const std::uint8_t> chunk);
+Digest node_hash(const Digest& left, const Digest& right);
+
+struct SegmentSeal {
+    std::uint32_t key_ver = 0;
+    std::uint64_t start_ms = 0;
+    std::uint64_t chunk_ms = 0;
+    std::uint64_t chunks = 0;
+    Packet pkt;
+};
+
+struct RangeProof {
+    std::uint64_t first = 0;
+    std::uint64_t count = 0;
+    std::vector<Digest> nodes;
+};
+
+class SegmentTree {
+public:
+    static SegmentTree build(ChunkList chunks, std::uint64_t start_ms, std::uint64_t chunk_ms, std::size_t threads = 0);
+
+    const Digest& root() const { return levels_.back().front(); }
+    std::uint64_t chunks() const { return levels_.front().size(); }
+    std::uint64_t start_ms() const { return start_ms_; }
+    std::uint64_t chunk_ms() const { return chunk_ms_; }
+
+    RangeProof prove(std::uint64_t from_ms, std::uint64_t to_ms) const;
+    RangeProof prove_chunks(std::uint64_t first, std::uint64_t count) const;
+    SegmentSeal seal(const CipherRig& rig, std::uint32_t key_ver) const;
+
+private:
+    SegmentTree() = default;
+
+    std::uint64_t start_ms_ = 0;
+    std::uint64_t chunk_ms_ = 0;
+    std::vector<std::vector<Digest>> levels_;
+};
+
+bool verify_range(const SegmentSeal& seal, const CipherRig& rig, ChunkList excerpt, const RangeProof& proof);
+
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "syncstream/clock.hpp"
+#include "syncstream/keychain.hpp"
+#include "syncstream/middleware.hpp"
+#include "syncstream/replay.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+
+namespace syncstream {
+
+inline constexpr std::size_t pub_len = 32;
+inline constexpr std::size_t salt_len = 16;
+
+struct Ticket {
+    std::uint32_t key_ver = 0;
+    std::uint64_t issued_ms = 0;
+    Packet pkt;
+};
+
+struct Hello {
+    DevId dev;
+    std::uint32_t key_ver = 0;
+    std::array<std::uint8_t, pub_len> pub{};
+    std::array<std::uint8_t, salt_len> nonce{};
+    std::optional<Ticket> ticket;
+};
+
+struct Welcome {
+    std::array<std::uint8_t, pub_len> pub{};
+    std::array<std::uint8_t, salt_len> nonce{};
+    std::array<std::uint8_t, key_len> proof{};
+    Ticket ticket;
+    bool resumed = false;
+};
+
+struct Accepted {
+    Welcome welcome;
+    SecureBlob key;
+};
+
+struct SessionStats {
+    std::uint64_t full;
+    std::uint64_t resumed;
+    std::uint64_t rejected;
+};
+
+class SessionGate {
+public:
+    SessionGate(Keychain& keys, std::chrono::milliseconds ticket_life, std::shared_ptr<const Clock> clock = default_clock());
+
+    Accepted accept(const Hello& hello);
+    SessionStats stats() const;
+    std::size_t cached_rigs() const;
+
+private:
+    std::optional<SecureBlob> redeem(const Hello& hello, std::uint64_t now);
+    Ticket issue(std::string_view dev, std::span<const std::uint8_t> resume, std::uint64_t now);
+    std::shared_ptr<const CipherRig> rig_for(std::uint32_t ver);
+
+    Keychain& keys_;
+    std::shared_ptr<const Clock> clock_;
+    std::uint64_t life_;
+    std::unordered_map<std::uint32_t, std::shared_ptr<const CipherRig>> rigs_;
+    ReplayWheel spent_;
+    std::atomic<std::uint64_t> full_{0};
+    std::atomic<std::uint64_t> resumed_{0};
+    std::atomic<std::uint64_t> rejected_{0};
+    mutable std::mutex mu_;
+};
+
+class SessionClient {
+public:
+    SessionClient(Keychain& keys, DevId dev);
+
+    Hello hello();
+    SecureBlob finish(const Welcome& welcome);
+    bool can_resume() const { return ticket_.has_value(); }
+    void forget();
+
+private:
+    Keychain& keys_;
+    DevId dev_;
+    std::optional<Ticket> ticket_;
+    SecureBlob resume_;
+    SecureBlob eph_;
+    Hello sent_;
+};
+
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "syncstream/edge_hub.hpp"
+#include "syncstream/spsc_ring.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace syncstream {
+
+struct Opened {
+    std::uint64_t tag = 0;
+    std::optional<Ctrl> ctrl;
+    std::string err;
+};
+
+class ShardedHub {
+public:
+    ShardedHub(std::array<std::uint8_t, key_len> master, std::chrono::milliseconds max_skew, std::size_t replay_hint, std::size_t burst, std::size_t refill_per_sec,
+               std::size_t shards, std::size_t ring_depth = 1024, bool pin = true, std::chrono::milliseconds overlap = std::chrono::seconds(30),
+               std::shared_ptr<const Clock> clock = default_clock());
+    ~ShardedHub();
+    ShardedHub(const ShardedHub&) = delete;
+    ShardedHub& operator=(const ShardedHub&) = delete;
+
+    void stage_key(std::uint32_t ver, std::span<const std::uint8_t> salt, std::span<const std::uint8_t> ctx, bool activate_now, Suite suite = Suite::aes_gcm);
+    void activate_key(std::uint32_t ver);
+    void allow_cmd(Cmd cmd);
+
+    // Shard rings are single-producer/single-consumer: call submit from one ingress thread and poll from one
+    // drain thread (they may be the same). Debug builds assert that each stays on the thread that first called it.
+    bool submit(std::uint64_t tag, std::string_view dev, const VersionedEnv& env);
+    std::size_t poll(std::vector<Opened>& out, std::size_t max = 256);
+
+    std::size_t shards() const { return shards_.size(); }
+    std::size_t shard_of(std::string_view dev) const;
+    std::uint64_t handled(std::size_t shard) const;
+
+private:
+    struct Job {
+        std::uint64_t tag = 0;
+        DevId dev;
+        VersionedEnv env{};
+    };
+
+    struct Shard {
+        Shard(std::array<std::uint8_t, key_len> master, std::chrono::milliseconds max_skew, std::size_t replay_hint, std::size_t burst, std::size_t refill_per_sec,
+              std::size_t ring_depth, std::chrono::milliseconds overlap, std::shared_ptr<const Clock> clock);
+
+        EdgeHub hub;
+        SpscRing<Job> in;
+        SpscRing<Opened> out;
+        std::atomic<std::uint32_t> bell{0};
+        std::atomic<bool> sleeping{false};
+        std::atomic<std::uint64_t> handled{0};
+        std::jthread worker;
+    };
+
+    static void run(Shard& shard, std::stop_token stop);
+    static void claim(std::atomic<std::thread::id>& owner);
+
+    std::vector<std::unique_ptr<Shard>> shards_;
+    std::size_t next_poll_ = 0;
+    std::atomic<std::thread::id> submitter_{};
+    std::atomic<std::thread::id> poller_{};
+};
+
+}
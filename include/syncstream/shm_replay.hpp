@@ -0,0 +1,40 @@
+#pragma once
+
+#include "syncstream/replay.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace syncstream {
+
+class ShmReplay final : public ReplayStore {
+public:
+    ShmReplay(const std::string& name, std::size_t slots, std::chrono::milliseconds window);
+    ~ShmReplay() override;
+    ShmReplay(const ShmReplay&) = delete;
+    ShmReplay& operator=(const ShmReplay&) = delete;
+
+    static void unlink(const std::string& name);
+
+    bool seen_or_mark(const ReplayKey& key, std::uint64_t at_ms, std::uint64_t now) override;
+    std::size_t size(std::uint64_t now) const override;
+    std::uint64_t window() const override;
+    std::size_t capacity() const;
+
+private:
+    struct Head;
+
+    bool expired(std::uint64_t epoch, std::uint64_t now) const;
+    bool holds(std::uint64_t h, std::uint64_t fp, std::uint64_t epoch) const;
+    std::atomic<std::uint64_t>* part(std::uint64_t epoch) const;
+
+    Head* head_ = nullptr;
+    std::atomic<std::uint64_t>* table_ = nullptr;
+    std::size_t map_len_ = 0;
+    int fd_ = -1;
+};
+
+}
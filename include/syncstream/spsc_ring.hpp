@@ -0,0 +1,65 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace syncstream {
+
+template <typename T>
+class SpscRing {
+public:
+    explicit SpscRing(std::size_t capacity) : mask_(round_up(capacity) - 1), slots_(mask_ + 1) {}
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    bool push(T&& item) {
+        const auto tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_cache_ > mask_) {
+            head_cache_ = head_.load(std::memory_order_acquire);
+            if (tail - head_cache_ > mask_) {
+                return false;
+            }
+        }
+        slots_[tail & mask_] = std::move(item);
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T& out) {
+        const auto head = head_.load(std::memory_order_relaxed);
+        if (head == tail_cache_) {
+            tail_cache_ = tail_.load(std::memory_order_acquire);
+            if (head == tail_cache_) {
+                return false;
+            }
+        }
+        out = std::move(slots_[head & mask_]);
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const { return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire); }
+    std::size_t capacity() const { return mask_ + 1; }
+
+private:
+    static std::size_t round_up(std::size_t n) {
+        std::size_t cap = 2;
+        while (cap < n) {
+            cap <<= 1;
+        }
+        return cap;
+    }
+
+    static constexpr std::size_t line = 64;
+
+    const std::size_t mask_;
+    std::vector<T> slots_;
+    alignas(line) std::atomic<std::size_t> head_{0};
+    std::size_t tail_cache_ = 0;
+    alignas(line) std::atomic<std::size_t> tail_{0};
+    std::size_t head_cache_ = 0;
+};
+
+}
@@ -0,0 +1,143 @@
+#pragma once
+
+#include "syncstream/ack.hpp"
+#include "syncstream/schema.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace syncstream {
+
+namespace detail {
+
+template <typename T, std::size_t I>
+void put_changed(const T* base, const T& next, std::vector<std::uint8_t>& out, std::size_t& at) {
+    const auto f = std::get<I>(BodyLayout<T>::fields);
+    if (base == nullptr || !(base->*f == next.*f)) {
+        out[0] = static_cast<std::uint8_t>(out[0] | (1U << I));
+        put_field(out.data(), at, next.*f);
+    }
+}
+
+template <typename T, std::size_t I>
+bool get_changed(T& next, std::span<const std::uint8_t> delta, std::size_t& at) {
+    const auto f = std::get<I>(BodyLayout<T>::fields);
+    if (((delta[0] >> I) & 1U) == 0) {
+        return true;
+    }
+    using M = typename member_of<std::remove_const_t<decltype(f)>>::type;
+    return at + wire_of<M>() <= delta.size() && get_field(delta, at, next.*f);
+}
+
+template <typename T, std::size_t... I>
+void put_delta(const T* base, const T& next, std::vector<std::uint8_t>& out, std::size_t& at, std::index_sequence<I...>) {
+    (put_changed<T, I>(base, next, out, at), ...);
+}
+
+template <typename T, std::size_t... I>
+bool get_delta(T& next, std::span<const std::uint8_t> delta, std::size_t& at, std::index_sequence<I...>) {
+    return (get_changed<T, I>(next, delta, at) && ...);
+}
+
+}
+
+template <typename T>
+inline constexpr std::size_t field_count_v = std::tuple_size_v<std::remove_const_t<decltype(BodyLayout<T>::fields)>>;
+
+template <typename T>
+std::vector<std::uint8_t> encode_delta(const T* base, const T& next) {
+    static_assert(field_count_v<T> <= 8, "delta mask holds eight fields");
+    std::vector<std::uint8_t> out(1 + wire_size_v<T>);
+    std::size_t at = 1;
+    detail::put_delta(base, next, out, at, std::make_index_sequence<field_count_v<T>>{});
+    out.resize(at);
+    return out;
+}
+
+template <typename T>
+bool apply_delta(T& cfg, std::span<const std::uint8_t> delta, bool full) {
+    constexpr auto all = static_cast<std::uint8_t>((1U << field_count_v<T>) - 1U);
+    if (delta.empty() || (delta[0] & ~all) != 0 || (full && delta[0] != all)) {
+        return false;
+    }
+    T next = cfg;
+    std::size_t at = 1;
+    if (!detail::get_delta(next, delta, at, std::make_index_sequence<field_count_v<T>>{}) || at != delta.size() || !BodyLayout<T>::ok(next)) {
+        return false;
+    }
+    cfg = next;
+    return true;
+}
+
+struct SyncDelta {
+    std::uint32_t ver;
+    std::uint32_t gap;
+    std::span<const std::uint8_t> delta;
+};
+
+std::optional<SyncDelta> read_delta(std::span<const std::uint8_t> body);
+
+template <>
+struct BodyLayout<SyncDelta> {
+    static bool fits(std::span<const std::uint8_t> body);
+};
+
+struct SyncOut {
+    Ctrl ctrl;
+    std::uint32_t ver;
+    bool full;
+};
+
+class SyncSender {
+public:
+    SyncOut stage(const DevId& dev, const SyncBody& cfg, std::uint64_t now);
+    void sent(std::string_view dev, std::uint32_t ver, const VersionedEnv& env);
+    std::size_t on_ack(std::string_view dev, const Ack& ack);
+    void lost(std::string_view dev, const VersionedEnv& env);
+    void reset(std::string_view dev);
+    std::optional<std::uint32_t> base(std::string_view dev) const;
+    std::size_t staged(std::string_view dev) const;
+
+private:
+    struct Peer {
+        std::uint32_t next = 0;
+        std::optional<std::pair<std::uint32_t, SyncBody>> acked;
+        std::map<std::uint32_t, SyncBody> staged;
+        std::map<std::pair<std::uint32_t, std::uint64_t>, std::uint32_t> inflight;
+    };
+
+    std::unordered_map<std::string, Peer> peers_;
+    mutable std::mutex mu_;
+};
+
+enum class SyncApply : std::uint8_t {
+    applied = 1,
+    stale = 2,
+    diverged = 3
+};
+
+class SyncMirror {
+public:
+    explicit SyncMirror(std::size_t history = 8);
+
+    SyncApply apply(std::span<const std::uint8_t> body);
+    std::optional<std::pair<std::uint32_t, SyncBody>> current() const;
+
+private:
+    std::size_t history_;
+    std::deque<std::pair<std::uint32_t, SyncBody>> kept_;
+    mutable std::mutex mu_;
+};
+
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "syncstream/edge_hub.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace syncstream {
+
+struct TenantConfig {
+    std::size_t burst = 20;
+    std::size_t refill_per_sec = 10;
+    std::size_t max_bytes = 16 * 1024;
+    std::chrono::milliseconds rate_idle = std::chrono::minutes(1);
+};
+
+struct TenantUsage {
+    std::size_t bytes;
+    std::size_t limit;
+    std::size_t cores;
+    std::size_t replay;
+    std::size_t devices;
+};
+
+class TenantHub {
+public:
+    TenantHub(std::chrono::milliseconds max_skew, std::size_t budget_bytes, std::chrono::milliseconds overlap = std::chrono::seconds(30),
+              std::shared_ptr<const Clock> clock = default_clock());
+
+    void add_tenant(std::string_view id, std::array<std::uint8_t, key_len> master, TenantConfig cfg = {});
+    void drop_tenant(std::string_view id);
+    void stage_key(std::string_view id, std::uint32_t ver, std::span<const std::uint8_t> salt, std::span<const std::uint8_t> ctx, bool activate_now,
+                   Suite suite = Suite::aes_gcm);
+    void activate_key(std::string_view id, std::uint32_t ver);
+    void allow_cmd(std::string_view id, Cmd cmd);
+
+    VersionedEnv seal(std::string_view id, const Ctrl& ctrl);
+    Ctrl open(std::string_view id, const VersionedEnv& env);
+
+    TenantUsage usage(std::string_view id) const;
+    std::size_t tenants() const;
+    std::size_t reserved() const;
+    std::size_t budget() const { return budget_; }
+
+private:
+    struct Tenant {
+        Tenant(std::array<std::uint8_t, key_len> master, const TenantConfig& cfg, std::chrono::milliseconds overlap, CoreRing::Build build);
+
+        Keychain keys;
+        RateGate rate;
+        PolicyGate policy;
+        std::size_t limit;
+        CoreRing ring;
+        std::atomic<std::size_t> bound{0};
+        std::atomic<std::uint64_t> checked{0};
+        mutable std::mutex mu;
+    };
+
+    struct IdHash {
+        using is_transparent = void;
+        std::size_t operator()(std::string_view id) const { return std::hash<std::string_view>{}(id); }
+    };
+
+    std::shared_ptr<Tenant> find(std::string_view id) const;
+    std::shared_ptr<RelayCore> core_for(Tenant& t, std::uint32_t ver, std::uint64_t now);
+    static bool admit(Tenant& t, std::size_t grow, std::uint64_t now);
+    static TenantUsage measure(const Tenant& t);
+
+    std::chrono::milliseconds max_skew_;
+    std::size_t budget_;
+    std::chrono::milliseconds overlap_;
+    std::shared_ptr<const Clock> clock_;
+    std::unordered_map<std::string, std::shared_ptr<Tenant>, IdHash, std::equal_to<>> tenants_;
+    std::size_t reserved_ = 0;
+    mutable std::shared_mutex mu_;
+};
+
+}
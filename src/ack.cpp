@@ -0,0 +1,225 @@
+#include "syncstream/ack.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace syncstream {
+namespace {
+
+[[noreturn]] void die(const std::string& msg) {
+    throw std::runtime_error(msg);
+}
+
+}
+
+bool Ack::covers(std::uint64_t seq) const {
+    if (seq <= cum || seq == top) {
+        return true;
+    }
+    if (seq > top) {
+        return false;
+    }
+    const auto off = top - 1 - seq;
+    return off < sack_bits && ((sack >> off) & 1U) != 0;
+}
+
+bool Ack::abandons(std::uint64_t seq) const {
+    return seq > cum && seq < top && top - 1 - seq >= sack_bits;
+}
+
+Body pack_ack(const Ack& ack) {
+    const auto raw = encode_body(ack);
+    return Body(std::span<const std::uint8_t>(raw));
+}
+
+Ack unpack_ack(std::span<const std::uint8_t> body) {
+    Ack ack{};
+    if (!try_decode_body(body, ack)) {
+        die("ack invalid");
+    }
+    return ack;
+}
+
+AckWindow::AckWindow(std::chrono::milliseconds every, std::size_t per) : every_(0), per_(per) {
+    if (every.count() <= 0 || per_ == 0) {
+        die("ack window config invalid");
+    }
+    every_ = static_cast<std::uint64_t>(every.count());
+}
+
+std::string AckWindow::key_of(std::string_view dev, std::uint32_t key_ver) {
+    std::string key(dev);
+    key.push_back('\0');
+    for (int i = 3; i >= 0; --i) {
+        key.push_back(static_cast<char>((key_ver >> (i * 8)) & 0xFFU));
+    }
+    return key;
+}
+
+void AckWindow::note(std::string_view dev, std::uint32_t key_ver, std::uint64_t seq, std::uint64_t now) {
+    if (seq == 0) {
+        die("ack seq invalid");
+    }
+    auto key = key_of(dev, key_ver);
+    std::scoped_lock lock(mu_);
+    auto it = tracks_.find(key);
+    if (it == tracks_.end()) {
+        it = tracks_.emplace(key, Track{DevId(dev), Ack{key_ver, 0, 0, 0}}).first;
+    }
+    auto& t = it->second;
+    auto& a = t.ack;
+    if (seq > a.top) {
+        const auto shift = seq - a.top;
+        a.sack = shift >= sack_bits ? 0 : a.sack << shift;
+        if (a.top > a.cum && shift <= sack_bits) {
+            a.sack |= std::uint64_t{1} << (shift - 1);
+        }
+        a.top = seq;
+    } else if (seq == a.cum + 1) {
+        a.cum = seq;
+    } else if (seq > a.cum && seq < a.top && a.top - 1 - seq < sack_bits) {
+        a.sack |= std::uint64_t{1} << (a.top - 1 - seq);
+    }
+    while (a.cum < a.top) {
+        if (a.cum + 1 == a.top) {
+            a.cum = a.top;
+            a.sack = 0;
+            break;
+        }
+        const auto off = a.top - 2 - a.cum;
+        if (off >= sack_bits || ((a.sack >> off) & 1U) == 0) {
+            break;
+        }
+        a.sack &= ~(std::uint64_t{1} << off);
+        ++a.cum;
+    }
+
+    ++t.pending;
+    if (!t.queued) {
+        t.queued = true;
+        timers_.push_back(Timer{now + every_, t.gen, key});
+    }
+    if (t.pending >= per_ && !t.full) {
+        t.full = true;
+        full_.push_back(std::move(key));
+    }
+}
+
+void AckWindow::flush(Track& t, std::uint64_t now, std::vector<Ctrl>& out) {
+    if (t.pending == 0) {
+        return;
+    }
+    out.push_back(Ctrl{t.dev, Cmd::ack, now, pack_ack(t.ack)});
+    t.pending = 0;
+    t.queued = false;
+    t.full = false;
+    ++t.gen;
+}
+
+std::vector<Ctrl> AckWindow::due(std::uint64_t now) {
+    std::vector<Ctrl> out;
+    std::scoped_lock lock(mu_);
+    for (const auto& key : full_) {
+        const auto it = tracks_.find(key);
+        if (it != tracks_.end() && it->second.full) {
+            flush(it->second, now, out);
+        }
+    }
+    full_.clear();
+    while (!timers_.empty() && timers_.front().at <= now) {
+        const auto it = tracks_.find(timers_.front().key);
+        if (it != tracks_.end() && it->second.gen == timers_.front().gen) {
+            flush(it->second, now, out);
+        }
+        timers_.pop_front();
+    }
+    return out;
+}
+
+std::optional<Ack> AckWindow::state(std::string_view dev, std::uint32_t key_ver) const {
+    std::scoped_lock lock(mu_);
+    const auto it = tracks_.find(key_of(dev, key_ver));
+    if (it == tracks_.end()) {
+        return std::nullopt;
+    }
+    return it->second.ack;
+}
+
+std::size_t AckWindow::pending() const {
+    std::scoped_lock lock(mu_);
+    std::size_t n = 0;
+    for (const auto& kv : tracks_) {
+        n += kv.second.pending;
+    }
+    return n;
+}
+
+RetryBook::RetryBook(std::chrono::milliseconds rto, std::chrono::milliseconds life, std::chrono::milliseconds max_rto) : rto_(0), life_(0), max_rto_(0) {
+    if (rto.count() <= 0 || life.count() <= 0 || max_rto < rto) {
+        die("retry config invalid");
+    }
+    rto_ = static_cast<std::uint64_t>(rto.count());
+    life_ = static_cast<std::uint64_t>(life.count());
+    max_rto_ = static_cast<std::uint64_t>(max_rto.count());
+}
+
+std::uint64_t RetryBook::next_seq(std::string_view dev, std::uint32_t key_ver) {
+    std::scoped_lock lock(mu_);
+    return ++seqs_[Stream{std::string(dev), key_ver}];
+}
+
+void RetryBook::track(std::string_view dev, const VersionedEnv& env, std::uint64_t now) {
+    std::scoped_lock lock(mu_);
+    sent_.insert_or_assign({std::string(dev), env.key_ver, env.env.seq}, Entry{Retry{DevId(dev), env}, now, now + rto_, rto_});
+}
+
+std::size_t RetryBook::on_ack(std::string_view dev, const Ack& ack) {
+    std::scoped_lock lock(mu_);
+    std::size_t gone = 0;
+    const std::string id(dev);
+    for (auto it = sent_.lower_bound({id, ack.key_ver, 0}); it != sent_.end() && std::get<0>(it->first) == id && std::get<1>(it->first) == ack.key_ver;) {
+        const auto seq = std::get<2>(it->first);
+        if (seq > ack.top) {
+            break;
+        }
+        if (ack.covers(seq)) {
+            it = sent_.erase(it);
+            ++gone;
+        } else if (ack.abandons(seq)) {
+            dropped_.push_back(std::move(it->second.item));
+            it = sent_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    return gone;
+}
+
+RetryPlan RetryBook::due(std::uint64_t now) {
+    RetryPlan plan;
+    std::scoped_lock lock(mu_);
+    plan.lost = std::move(dropped_);
+    dropped_.clear();
+    for (auto it = sent_.begin(); it != sent_.end();) {
+        auto& e = it->second;
+        if (now - std::min(now, e.first) >= life_) {
+            plan.lost.push_back(std::move(e.item));
+            it = sent_.erase(it);
+            continue;
+        }
+        if (now >= e.next) {
+            plan.resend.push_back(e.item);
+            e.rto = std::min(max_rto_, e.rto * 2);
+            e.next = now + e.rto;
+        }
+        ++it;
+    }
+    return plan;
+}
+
+std::size_t RetryBook::inflight() const {
+    std::scoped_lock lock(mu_);
+    return sent_.size();
+}
+
+}
@@ -0,0 +1,125 @@
+#include "syncstream/async.hpp"
+
+#include <stdexcept>
+#include <string>
+
+namespace syncstream {
+namespace {
+
+[[noreturn]] void die(const std::string& msg) {
+    throw std::runtime_error(msg);
+}
+
+}
+
+void InlineExecutor::post(std::coroutine_handle<> h) {
+    thread_local std::deque<std::coroutine_handle<>> queue;
+    thread_local bool draining = false;
+    queue.push_back(h);
+    if (draining) {
+        return;
+    }
+    draining = true;
+    while (!queue.empty()) {
+        const auto next = queue.front();
+        queue.pop_front();
+        next.resume();
+    }
+    draining = false;
+}
+
+PoolExecutor::PoolExecutor(std::size_t threads) {
+    if (threads == 0) {
+        die("executor needs threads");
+    }
+    workers_.reserve(threads);
+    for (std::size_t i = 0; i < threads; ++i) {
+        workers_.emplace_back([this] { run(); });
+    }
+}
+
+PoolExecutor::~PoolExecutor() {
+    {
+        std::scoped_lock lock(mu_);
+        stop_ = true;
+    }
+    cv_.notify_all();
+    for (auto& w : workers_) {
+        w.join();
+    }
+}
+
+void PoolExecutor::post(std::coroutine_handle<> h) {
+    {
+        std::scoped_lock lock(mu_);
+        q_.push_back(h);
+    }
+    cv_.notify_one();
+}
+
+void PoolExecutor::run() {
+    for (;;) {
+        std::coroutine_handle<> h;
+        {
+            std::unique_lock lock(mu_);
+            cv_.wait(lock, [this] { return stop_ || !q_.empty(); });
+            if (q_.empty()) {
+                return;
+            }
+            h = q_.front();
+            q_.pop_front();
+        }
+        h.resume();
+    }
+}
+
+void AsyncMutex::lock() {
+    std::unique_lock lock(mu_);
+    if (!held_) {
+        held_ = true;
+        return;
+    }
+    bool ready = false;
+    waiters_.push_back(Waiter{{}, nullptr, &ready});
+    cv_.wait(lock, [&] { return ready; });
+}
+
+bool AsyncMutex::try_lock() {
+    std::scoped_lock lock(mu_);
+    if (held_) {
+        return false;
+    }
+    held_ = true;
+    return true;
+}
+
+bool AsyncMutex::park(std::coroutine_handle<> h, Executor& ex) {
+    std::scoped_lock lock(mu_);
+    if (!held_) {
+        held_ = true;
+        return false;
+    }
+    waiters_.push_back(Waiter{h, &ex});
+    return true;
+}
+
+void AsyncMutex::unlock() {
+    Waiter next{};
+    {
+        std::scoped_lock lock(mu_);
+        if (waiters_.empty()) {
+            held_ = false;
+            return;
+        }
+        next = waiters_.front();
+        waiters_.pop_front();
+        if (next.ready) {
+            *next.ready = true;
+            cv_.notify_all();
+            return;
+        }
+    }
+    next.ex->post(next.h);
+}
+
+}
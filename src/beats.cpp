@@ -0,0 +1,138 @@
+#include "syncstream/beats.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace syncstream {
+namespace {
+
+constexpr std::size_t beat_overhead = 2 + 8;
+
+[[noreturn]] void die(const std::string& msg) {
+    throw std::runtime_error(msg);
+}
+
+void put_u16(std::vector<std::uint8_t>& out, std::size_t v) {
+    out.push_back(static_cast<std::uint8_t>((v >> 8) & 0xFFU));
+    out.push_back(static_cast<std::uint8_t>(v & 0xFFU));
+}
+
+void put_u64(std::vector<std::uint8_t>& out, std::uint64_t v) {
+    for (int i = 7; i >= 0; --i) {
+        out.push_back(static_cast<std::uint8_t>((v >> (i * 8)) & 0xFFU));
+    }
+}
+
+std::size_t read_u16(std::span<const std::uint8_t> raw, std::size_t& at) {
+    if (at + 2 > raw.size()) {
+        die("beat bounds");
+    }
+    const std::size_t v = (static_cast<std::size_t>(raw[at]) << 8) | raw[at + 1];
+    at += 2;
+    return v;
+}
+
+std::uint64_t read_u64(std::span<const std::uint8_t> raw, std::size_t& at) {
+    if (at + 8 > raw.size()) {
+        die("beat bounds");
+    }
+    std::uint64_t v = 0;
+    for (std::size_t i = 0; i < 8; ++i) {
+        v = (v << 8) | raw[at + i];
+    }
+    at += 8;
+    return v;
+}
+
+}
+
+std::vector<Beat> unpack_beats(std::span<const std::uint8_t> body) {
+    std::size_t at = 0;
+    const auto count = read_u16(body, at);
+    std::vector<Beat> out;
+    out.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        const auto len = read_u16(body, at);
+        if (len == 0 || at + len > body.size()) {
+            die("beat dev bounds");
+        }
+        Beat beat{};
+        beat.dev = std::string_view(reinterpret_cast<const char*>(body.data() + at), len);
+        at += len;
+        beat.at_ms = read_u64(body, at);
+        out.push_back(std::move(beat));
+    }
+    if (at != body.size()) {
+        die("trailing beat bytes");
+    }
+    return out;
+}
+
+BeatBatch::BeatBatch(DevId gateway, std::size_t max_beats) : gateway_(std::move(gateway)), max_(max_beats) {
+    if (gateway_.empty()) {
+        die("gateway id missing");
+    }
+    if (max_ == 0 || max_ > 0xFFFFU) {
+        die("beat batch size invalid");
+    }
+    beats_.reserve(max_);
+}
+
+bool BeatBatch::add(std::string_view dev, std::uint64_t at_ms) {
+    if (dev.empty() || dev.size() > 0xFFFFU) {
+        die("beat dev invalid");
+    }
+    const auto it = index_.find(std::string(dev));
+    if (it != index_.end()) {
+        auto& held = beats_[it->second];
+        held.at_ms = std::max(held.at_ms, at_ms);
+        return full();
+    }
+    if (beats_.size() >= max_ || bytes_ + beat_overhead + dev.size() > max_bytes_) {
+        die("beat batch full");
+    }
+    index_.emplace(std::string(dev), beats_.size());
+    beats_.push_back(Beat{dev, at_ms});
+    bytes_ += beat_overhead + dev.size();
+    return full();
+}
+
+bool BeatBatch::full() const {
+    return beats_.size() >= max_ || bytes_ + beat_overhead + inline_len > max_bytes_;
+}
+
+Ctrl BeatBatch::take(std::uint64_t now) {
+    std::vector<std::uint8_t> body;
+    body.reserve(bytes_);
+    put_u16(body, beats_.size());
+    for (const auto& beat : beats_) {
+        put_u16(body, beat.dev.size());
+        body.insert(body.end(), beat.dev.begin(), beat.dev.end());
+        put_u64(body, beat.at_ms);
+    }
+    beats_.clear();
+    index_.clear();
+    bytes_ = 2;
+    return Ctrl{gateway_, Cmd::beats, now, Body(body)};
+}
+
+bool BodyLayout<BeatBatch>::fits(std::span<const std::uint8_t> body) {
+    if (body.size() < 2) {
+        return false;
+    }
+    const std::size_t count = (static_cast<std::size_t>(body[0]) << 8) | body[1];
+    std::size_t at = 2;
+    for (std::size_t i = 0; i < count; ++i) {
+        if (at + 2 > body.size()) {
+            return false;
+        }
+        const std::size_t len = (static_cast<std::size_t>(body[at]) << 8) | body[at + 1];
+        if (len == 0 || at + 2 + len + 8 > body.size()) {
+            return false;
+        }
+        at += 2 + len + 8;
+    }
+    return at == body.size();
+}
+
+}
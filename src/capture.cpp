@@ -0,0 +1,213 @@
+#include "syncstream/capture.hpp"
+
+#include <openssl/rand.h>
+
+#include <algorithm>
+#include <exception>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace syncstream {
+namespace {
+
+constexpr std::size_t head_len = 8 + 4 + 8 + 8 + 1 + nonce_len + tag_len + 4;
+constexpr std::size_t min_per_worker = 256;
+
+[[noreturn]] void die(const std::string& msg) {
+    throw std::runtime_error(msg);
+}
+
+void put_be(std::vector<std::uint8_t>& out, std::uint64_t v, int bytes) {
+    for (int i = bytes - 1; i >= 0; --i) {
+        out.push_back(static_cast<std::uint8_t>((v >> (i * 8)) & 0xFFU));
+    }
+}
+
+std::uint64_t get_be(std::span<const std::uint8_t> raw, std::size_t& at, std::size_t bytes) {
+    std::uint64_t v = 0;
+    for (std::size_t i = 0; i < bytes; ++i) {
+        v = (v << 8) | raw[at + i];
+    }
+    at += bytes;
+    return v;
+}
+
+CaptureRecord parse(std::span<const std::uint8_t> data, std::size_t at) {
+    CaptureRecord rec{};
+    rec.recv_ms = get_be(data, at, 8);
+    rec.env.key_ver = static_cast<std::uint32_t>(get_be(data, at, 4));
+    rec.env.env.seq = get_be(data, at, 8);
+    rec.env.env.at_ms = get_be(data, at, 8);
+    rec.env.env.pkt.suite = static_cast<Suite>(data[at]);
+    at += 1;
+    std::copy_n(data.begin() + static_cast<std::ptrdiff_t>(at), nonce_len, rec.env.env.pkt.nonce.begin());
+    at += nonce_len;
+    std::copy_n(data.begin() + static_cast<std::ptrdiff_t>(at), tag_len, rec.env.env.pkt.mac.begin());
+    at += tag_len;
+    const auto len = static_cast<std::size_t>(get_be(data, at, 4));
+    const auto body = data.subspan(at, len);
+    rec.env.env.pkt.body.assign(body.begin(), body.end());
+    return rec;
+}
+
+struct KeyHash {
+    std::uint64_t seed;
+    std::size_t operator()(const ReplayKey& key) const { return static_cast<std::size_t>(replay_hash(key, seed)); }
+};
+
+template <typename F>
+void fan_out(std::size_t workers, F&& fn) {
+    std::vector<std::exception_ptr> errs(workers);
+    {
+        std::vector<std::jthread> pool;
+        pool.reserve(workers - 1);
+        for (std::size_t id = 1; id < workers; ++id) {
+            pool.emplace_back([&, id] {
+                try {
+                    fn(id);
+                } catch (...) {
+                    errs[id] = std::current_exception();
+                }
+            });
+        }
+        try {
+            fn(0);
+        } catch (...) {
+            errs[0] = std::current_exception();
+        }
+    }
+    for (const auto& err : errs) {
+        if (err) {
+            std::rethrow_exception(err);
+        }
+    }
+}
+
+}
+
+const char* fault_name(Fault why) {
+    switch (why) {
+    case Fault::none:
+        return "none";
+    case Fault::malformed:
+        return "malformed";
+    case Fault::unknown_key:
+        return "unknown_key";
+    case Fault::skew:
+        return "skew";
+    case Fault::auth:
+        return "auth";
+    case Fault::replay:
+        return "replay";
+    }
+    return "unknown";
+}
+
+void append_record(std::vector<std::uint8_t>& out, const CaptureRecord& rec) {
+    const auto& pkt = rec.env.env.pkt;
+    if (pkt.body.size() > 0xFFFFFFFFU) {
+        die("capture body too long");
+    }
+    put_be(out, rec.recv_ms, 8);
+    put_be(out, rec.env.key_ver, 4);
+    put_be(out, rec.env.env.seq, 8);
+    put_be(out, rec.env.env.at_ms, 8);
+    out.push_back(static_cast<std::uint8_t>(pkt.suite));
+    out.insert(out.end(), pkt.nonce.begin(), pkt.nonce.end());
+    out.insert(out.end(), pkt.mac.begin(), pkt.mac.end());
+    put_be(out, pkt.body.size(), 4);
+    out.insert(out.end(), pkt.body.begin(), pkt.body.end());
+}
+
+VerifyReport verify_capture(std::span<const std::uint8_t> data, std::span<const VerifyKey> keys, std::chrono::milliseconds max_skew, std::size_t threads) {
+    std::unordered_map<std::uint32_t, std::unique_ptr<CipherRig>> rigs;
+    for (const auto& k : keys) {
+        rigs[k.ver] = std::make_unique<CipherRig>(k.key, k.suite);
+    }
+
+    std::vector<std::uint64_t> offsets;
+    std::size_t at = 0;
+    while (at + head_len <= data.size()) {
+        std::size_t len_at = at + head_len - 4;
+        const auto len = static_cast<std::size_t>(get_be(data, len_at, 4));
+        if (len > data.size() - at - head_len) {
+            break;
+        }
+        offsets.push_back(at);
+        at += head_len + len;
+    }
+
+    const auto n = offsets.size();
+    if (threads == 0) {
+        threads = std::max<std::size_t>(1, std::thread::hardware_concurrency());
+    }
+    threads = std::clamp<std::size_t>(n / min_per_worker, 1, threads);
+
+    std::vector<Fault> verdict(n, Fault::none);
+    std::vector<ReplayKey> seen(n);
+    const auto skew = static_cast<std::uint64_t>(max_skew.count());
+
+    fan_out(threads, [&](std::size_t id) {
+        const auto lo = n * id / threads;
+        const auto hi = n * (id + 1) / threads;
+        for (auto i = lo; i < hi; ++i) {
+            const auto rec = parse(data, offsets[i]);
+            const auto& env = rec.env.env;
+            const auto rig = rigs.find(rec.env.key_ver);
+            if (rig == rigs.end()) {
+                verdict[i] = Fault::unknown_key;
+                continue;
+            }
+            const auto gap = env.at_ms > rec.recv_ms ? env.at_ms - rec.recv_ms : rec.recv_ms - env.at_ms;
+            if (gap > skew) {
+                verdict[i] = Fault::skew;
+                continue;
+            }
+            try {
+                static_cast<void>(rig->second->open(env.pkt, env_aad(env.seq, env.at_ms)));
+            } catch (const std::exception&) {
+                verdict[i] = Fault::auth;
+                continue;
+            }
+            seen[i] = ReplayKey::of(env.seq, env.pkt);
+        }
+    });
+
+    std::uint64_t seed = 0;
+    if (RAND_bytes(reinterpret_cast<unsigned char*>(&seed), sizeof(seed)) != 1) {
+        die("replay seed failed");
+    }
+    fan_out(threads, [&](std::size_t id) {
+        std::unordered_set<ReplayKey, KeyHash> mine(0, KeyHash{seed});
+        for (std::size_t i = 0; i < n; ++i) {
+            if (verdict[i] != Fault::none || replay_hash(seen[i], ~seed) % threads != id) {
+                continue;
+            }
+            if (!mine.insert(seen[i]).second) {
+                verdict[i] = Fault::replay;
+            }
+        }
+    });
+
+    VerifyReport report{};
+    report.total = n;
+    for (std::size_t i = 0; i < n; ++i) {
+        if (verdict[i] == Fault::none) {
+            ++report.ok;
+            continue;
+        }
+        ++report.by_fault[static_cast<std::size_t>(verdict[i])];
+        report.faults.push_back(RecordFault{i, offsets[i], verdict[i]});
+    }
+    if (at != data.size()) {
+        ++report.total;
+        ++report.by_fault[static_cast<std::size_t>(Fault::malformed)];
+        report.faults.push_back(RecordFault{n, at, Fault::malformed});
+    }
+    return report;
+}
+
+}
@@ -0,0 +1,81 @@
+#include "syncstream/clock.hpp"
+
+#include <ctime>
+
+namespace syncstream {
+namespace {
+
+std::uint64_t sys_ms() {
+    const auto now = std::chrono::time_point_cast<std::chrono::milliseconds>(std::chrono::system_clock::now());
+    return static_cast<std::uint64_t>(now.time_since_epoch().count());
+}
+
+std::int64_t mono_ms() {
+    const auto now = std::chrono::time_point_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now());
+    return static_cast<std::int64_t>(now.time_since_epoch().count());
+}
+
+}
+
+std::uint64_t WallClock::now_ms() const {
+    return sys_ms();
+}
+
+std::uint64_t CoarseClock::now_ms() const {
+#if defined(CLOCK_REALTIME_COARSE)
+    timespec ts{};
+    if (clock_gettime(CLOCK_REALTIME_COARSE, &ts) == 0) {
+        return static_cast<std::uint64_t>(ts.tv_sec) * 1000U + static_cast<std::uint64_t>(ts.tv_nsec / 1000000);
+    }
+#endif
+    return sys_ms();
+}
+
+TickClock::TickClock(std::chrono::milliseconds period) : now_(sys_ms()) {
+    ticker_ = std::jthread([this, period](std::stop_token stop) {
+        std::unique_lock lock(mu_);
+        while (!stop.stop_requested()) {
+            static_cast<void>(cv_.wait_for(lock, stop, period, [] { return false; }));
+            now_.store(sys_ms(), std::memory_order_relaxed);
+        }
+    });
+}
+
+TickClock::~TickClock() {
+    ticker_.request_stop();
+}
+
+std::uint64_t TickClock::now_ms() const {
+    return now_.load(std::memory_order_relaxed);
+}
+
+MonoClock::MonoClock() : lead_(static_cast<std::int64_t>(sys_ms()) - mono_ms()) {}
+
+std::uint64_t MonoClock::now_ms() const {
+    return static_cast<std::uint64_t>(mono_ms() + lead_.load(std::memory_order_relaxed));
+}
+
+void MonoClock::resync() {
+    lead_.store(static_cast<std::int64_t>(sys_ms()) - mono_ms(), std::memory_order_relaxed);
+}
+
+ManualClock::ManualClock(std::uint64_t start) : now_(start) {}
+
+std::uint64_t ManualClock::now_ms() const {
+    return now_.load(std::memory_order_acquire);
+}
+
+void ManualClock::set(std::uint64_t at) {
+    now_.store(at, std::memory_order_release);
+}
+
+void ManualClock::advance(std::chrono::milliseconds by) {
+    now_.fetch_add(static_cast<std::uint64_t>(by.count()), std::memory_order_acq_rel);
+}
+
+std::shared_ptr<const Clock> default_clock() {
+    static const auto clock = std::make_shared<const MonoClock>();
+    return clock;
+}
+
+}
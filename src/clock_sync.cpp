@@ -0,0 +1,168 @@
+#include "syncstream/clock_sync.hpp"
+#include "syncstream/replay.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace syncstream {
+namespace {
+
+[[noreturn]] void die(const std::string& msg) {
+    throw std::runtime_error(msg);
+}
+
+std::uint64_t gap_of(std::int64_t a, std::int64_t b) {
+    return a > b ? static_cast<std::uint64_t>(a - b) : static_cast<std::uint64_t>(b - a);
+}
+
+}
+
+Body pack_echo(const Echo& echo) {
+    const auto raw = encode_body(echo);
+    return Body(std::span<const std::uint8_t>(raw));
+}
+
+std::optional<Echo> unpack_echo(std::span<const std::uint8_t> body) {
+    Echo echo{};
+    if (!try_decode_body(body, echo)) {
+        return std::nullopt;
+    }
+    return echo;
+}
+
+Ctrl answer_probe(const Ctrl& probe, std::uint64_t recv_ms, std::uint64_t send_ms) {
+    if (probe.cmd != Cmd::ping) {
+        die("probe must be ping");
+    }
+    return Ctrl{probe.dev, Cmd::ping, send_ms, pack_echo(Echo{probe.at_ms, recv_ms})};
+}
+
+std::optional<OffsetSample> sample_of(std::uint64_t t1, std::uint64_t t2, std::uint64_t t3, std::uint64_t t4) {
+    if (t4 < t1 || t3 < t2 || t4 - t1 < t3 - t2) {
+        return std::nullopt;
+    }
+    const auto a = static_cast<std::int64_t>(t2) - static_cast<std::int64_t>(t1);
+    const auto b = static_cast<std::int64_t>(t3) - static_cast<std::int64_t>(t4);
+    return OffsetSample{(a + b) / 2, static_cast<std::int64_t>((t4 - t1) - (t3 - t2))};
+}
+
+ClockTracker::ClockTracker(std::chrono::milliseconds window, std::chrono::milliseconds reach, std::chrono::milliseconds floor, std::size_t depth)
+    : window_(0), reach_(0), floor_(0), depth_(depth), step_(0), hold_(0) {
+    if (window.count() <= 0) {
+        die("clock window must be positive");
+    }
+    if (reach.count() < 0 || floor.count() < 0) {
+        die("clock reach cannot be negative");
+    }
+    if (depth_ == 0) {
+        die("clock depth must be positive");
+    }
+    window_ = static_cast<std::uint64_t>(window.count());
+    reach_ = static_cast<std::uint64_t>(reach.count());
+    floor_ = static_cast<std::uint64_t>(floor.count());
+    step_ = static_cast<std::int64_t>(replay_span(window));
+    hold_ = 2 * window_ + 2 * static_cast<std::uint64_t>(step_);
+}
+
+bool ClockTracker::add(std::string_view dev, const OffsetSample& sample, std::uint64_t now) {
+    if (sample.rtt_ms < 0 || static_cast<std::uint64_t>(sample.rtt_ms) > window_) {
+        return false;
+    }
+    std::scoped_lock lock(mu_);
+    auto it = tracks_.find(dev);
+    const bool fresh = it == tracks_.end();
+    if (fresh) {
+        it = tracks_.emplace(std::string(dev), Track{}).first;
+        it->second.ring.reserve(depth_);
+    }
+    auto& t = it->second;
+    if (t.ring.size() < depth_) {
+        t.ring.push_back(sample);
+    } else {
+        t.ring[t.next] = sample;
+    }
+    t.next = (t.next + 1) % depth_;
+
+    const auto best = std::min_element(t.ring.begin(), t.ring.end(), [](const auto& a, const auto& b) { return a.rtt_ms < b.rtt_ms; });
+    t.target = best->offset_ms;
+    t.rtt = best->rtt_ms;
+    double sq = 0.0;
+    for (const auto& s : t.ring) {
+        const auto d = static_cast<double>(s.offset_ms - t.target);
+        sq += d * d;
+    }
+    t.jitter = static_cast<std::int64_t>(std::ceil(std::sqrt(sq / static_cast<double>(t.ring.size()))));
+
+    if (fresh && gap_of(t.target, 0) > 2 * window_) {
+        t.applied = t.target;
+        t.changed = now;
+    } else if (t.applied != t.target && (fresh || now - std::min(now, t.changed) >= hold_)) {
+        t.applied += std::clamp(t.target - t.applied, -step_, step_);
+        t.changed = now;
+    }
+    return true;
+}
+
+std::optional<ClockEstimate> ClockTracker::estimate(std::string_view dev) const {
+    std::scoped_lock lock(mu_);
+    const auto it = tracks_.find(dev);
+    if (it == tracks_.end()) {
+        return std::nullopt;
+    }
+    const auto& t = it->second;
+    return ClockEstimate{t.applied, t.target, t.jitter, t.rtt, margin(t), t.ring.size()};
+}
+
+std::uint64_t ClockTracker::margin(const Track& t) const {
+    const auto slack = gap_of(t.target, t.applied) + static_cast<std::uint64_t>(t.rtt) + 4 * static_cast<std::uint64_t>(t.jitter) + floor_;
+    return std::min(window_, slack);
+}
+
+std::optional<Echo> ClockTracker::fresh_echo(Cmd cmd, std::span<const std::uint8_t> body, std::uint64_t now) const {
+    if (cmd != Cmd::ping) {
+        return std::nullopt;
+    }
+    const auto echo = unpack_echo(body);
+    if (echo && (echo->probe_ms > now || now - echo->probe_ms > window_)) {
+        die("probe expired");
+    }
+    return echo;
+}
+
+std::uint64_t ClockTracker::admit(std::string_view dev, Cmd cmd, std::span<const std::uint8_t> body, std::uint64_t at_ms, std::uint64_t now) const {
+    if (const auto echo = fresh_echo(cmd, body, now)) {
+        return echo->probe_ms;
+    }
+    std::int64_t offset = 0;
+    std::uint64_t limit = window_;
+    {
+        std::scoped_lock lock(mu_);
+        const auto it = tracks_.find(dev);
+        if (it != tracks_.end()) {
+            offset = it->second.applied;
+            limit = margin(it->second);
+        }
+    }
+    const auto local = static_cast<std::int64_t>(at_ms) - offset;
+    if (local < 0 || gap_of(local, static_cast<std::int64_t>(now)) > limit) {
+        die("timestamp skew");
+    }
+    return static_cast<std::uint64_t>(local);
+}
+
+bool ClockTracker::learn(std::string_view dev, Cmd cmd, std::span<const std::uint8_t> body, std::uint64_t at_ms, std::uint64_t now) {
+    const auto echo = fresh_echo(cmd, body, now);
+    if (!echo) {
+        return false;
+    }
+    const auto sample = sample_of(echo->probe_ms, echo->recv_ms, at_ms, now);
+    return sample && add(dev, *sample, now);
+}
+
+std::size_t ClockTracker::size() const {
+    std::scoped_lock lock(mu_);
+    return tracks_.size();
+}
+
+}
@@ -0,0 +1,92 @@
+#include "syncstream/coalescer.hpp"
+
+#include <stdexcept>
+#include <utility>
+
+namespace syncstream {
+namespace {
+
+[[noreturn]] void die(const std::string& msg) {
+    throw std::runtime_error(msg);
+}
+
+bool mergeable(Cmd cmd) {
+    return cmd == Cmd::sync || cmd == Cmd::ping;
+}
+
+std::string key_of(const Ctrl& ctrl) {
+    std::string key;
+    key.reserve(ctrl.dev.size() + 1);
+    key.push_back(static_cast<char>(ctrl.cmd));
+    key.append(ctrl.dev.str());
+    return key;
+}
+
+}
+
+Coalescer::Coalescer(std::chrono::milliseconds window) : window_(static_cast<std::uint64_t>(window.count())) {
+    if (window.count() <= 0) {
+        die("coalesce window must be positive");
+    }
+}
+
+void Coalescer::push(Ctrl ctrl, std::uint64_t now) {
+    std::scoped_lock lock(mu_);
+    if (!mergeable(ctrl.cmd)) {
+        ready_.push_back(std::move(ctrl));
+        ++stats_.passed;
+        return;
+    }
+    auto key = key_of(ctrl);
+    const auto it = index_.find(key);
+    if (it != index_.end()) {
+        if (ctrl.cmd == Cmd::sync) {
+            ++stats_.merged_sync;
+        } else {
+            ++stats_.merged_ping;
+        }
+        held_[static_cast<std::size_t>(it->second - base_)].ctrl = std::move(ctrl);
+        return;
+    }
+    index_.emplace(key, base_ + held_.size());
+    held_.push_back(Held{std::move(ctrl), now + window_, std::move(key)});
+    ++stats_.held;
+}
+
+void Coalescer::pop_front(std::vector<Ctrl>& out) {
+    auto& front = held_.front();
+    index_.erase(front.key);
+    out.push_back(std::move(front.ctrl));
+    held_.pop_front();
+    ++base_;
+}
+
+std::vector<Ctrl> Coalescer::drain(std::uint64_t now) {
+    std::scoped_lock lock(mu_);
+    std::vector<Ctrl> out = std::exchange(ready_, {});
+    while (!held_.empty() && held_.front().due <= now) {
+        pop_front(out);
+    }
+    return out;
+}
+
+std::vector<Ctrl> Coalescer::flush() {
+    std::scoped_lock lock(mu_);
+    std::vector<Ctrl> out = std::exchange(ready_, {});
+    while (!held_.empty()) {
+        pop_front(out);
+    }
+    return out;
+}
+
+std::size_t Coalescer::pending() const {
+    std::scoped_lock lock(mu_);
+    return ready_.size() + held_.size();
+}
+
+CoalesceStats Coalescer::stats() const {
+    std::scoped_lock lock(mu_);
+    return stats_;
+}
+
+}
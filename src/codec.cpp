@@ -0,0 +1,444 @@
+#include "syncstream/codec.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SYNCSTREAM_X86 1
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define SYNCSTREAM_NEON 1
+#endif
+
+#include <array>
+#include <stdexcept>
+
+namespace syncstream {
+namespace {
+
+constexpr char hex_digits[] = "0123456789abcdef";
+constexpr char b64_digits[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+[[noreturn]] void die(const std::string& msg) {
+    throw std::runtime_error(msg);
+}
+
+constexpr std::array<std::int8_t, 256> hex_table() {
+    std::array<std::int8_t, 256> t{};
+    for (auto& v : t) {
+        v = -1;
+    }
+    for (int i = 0; i < 10; ++i) {
+        t[static_cast<std::size_t>('0' + i)] = static_cast<std::int8_t>(i);
+    }
+    for (int i = 0; i < 6; ++i) {
+        t[static_cast<std::size_t>('a' + i)] = static_cast<std::int8_t>(10 + i);
+        t[static_cast<std::size_t>('A' + i)] = static_cast<std::int8_t>(10 + i);
+    }
+    return t;
+}
+
+constexpr std::array<std::int8_t, 256> b64_table() {
+    std::array<std::int8_t, 256> t{};
+    for (auto& v : t) {
+        v = -1;
+    }
+    for (int i = 0; i < 64; ++i) {
+        t[static_cast<unsigned char>(b64_digits[i])] = static_cast<std::int8_t>(i);
+    }
+    return t;
+}
+
+constexpr auto hex_val = hex_table();
+constexpr auto b64_val = b64_table();
+
+std::size_t hex_encode_tail(const std::uint8_t* in, std::size_t n, char* out) {
+    for (std::size_t i = 0; i < n; ++i) {
+        out[i * 2] = hex_digits[in[i] >> 4];
+        out[i * 2 + 1] = hex_digits[in[i] & 0x0F];
+    }
+    return n;
+}
+
+std::size_t hex_decode_tail(const char* in, std::size_t n, std::uint8_t* out) {
+    for (std::size_t i = 0; i < n; ++i) {
+        const auto hi = hex_val[static_cast<unsigned char>(in[i * 2])];
+        const auto lo = hex_val[static_cast<unsigned char>(in[i * 2 + 1])];
+        if ((hi | lo) < 0) {
+            die("invalid hex character");
+        }
+        out[i] = static_cast<std::uint8_t>((hi << 4) | lo);
+    }
+    return n;
+}
+
+std::size_t b64_encode_tail(const std::uint8_t* in, std::size_t n, char* out) {
+    std::size_t o = 0;
+    std::size_t i = 0;
+    for (; i + 3 <= n; i += 3) {
+        const std::uint32_t v = (static_cast<std::uint32_t>(in[i]) << 16) | (static_cast<std::uint32_t>(in[i + 1]) << 8) | in[i + 2];
+        out[o++] = b64_digits[(v >> 18) & 0x3F];
+        out[o++] = b64_digits[(v >> 12) & 0x3F];
+        out[o++] = b64_digits[(v >> 6) & 0x3F];
+        out[o++] = b64_digits[v & 0x3F];
+    }
+    if (i < n) {
+        const std::uint32_t v = (static_cast<std::uint32_t>(in[i]) << 16) | (i + 1 < n ? static_cast<std::uint32_t>(in[i + 1]) << 8 : 0U);
+        out[o++] = b64_digits[(v >> 18) & 0x3F];
+        out[o++] = b64_digits[(v >> 12) & 0x3F];
+        out[o++] = i + 1 < n ? b64_digits[(v >> 6) & 0x3F] : '=';
+        out[o++] = '=';
+    }
+    return o;
+}
+
+std::size_t b64_decode_quads(const char* in, std::size_t quads, std::uint8_t* out) {
+    for (std::size_t q = 0; q < quads; ++q) {
+        const auto a = b64_val[static_cast<unsigned char>(in[q * 4])];
+        const auto b = b64_val[static_cast<unsigned char>(in[q * 4 + 1])];
+        const auto c = b64_val[static_cast<unsigned char>(in[q * 4 + 2])];
+        const auto d = b64_val[static_cast<unsigned char>(in[q * 4 + 3])];
+        if ((a | b | c | d) < 0) {
+            die("invalid base64 character");
+        }
+        const auto v = (static_cast<std::uint32_t>(a) << 18) | (static_cast<std::uint32_t>(b) << 12) | (static_cast<std::uint32_t>(c) << 6) | static_cast<std::uint32_t>(d);
+        out[q * 3] = static_cast<std::uint8_t>(v >> 16);
+        out[q * 3 + 1] = static_cast<std::uint8_t>(v >> 8);
+        out[q * 3 + 2] = static_cast<std::uint8_t>(v);
+    }
+    return quads * 3;
+}
+
+#if defined(SYNCSTREAM_X86)
+
+enum class Level { scalar, sse41, avx2 };
+
+Level level() {
+    static const Level picked = [] {
+        if (__builtin_cpu_supports("avx2")) {
+            return Level::avx2;
+        }
+        if (__builtin_cpu_supports("sse4.1")) {
+            return Level::sse41;
+        }
+        return Level::scalar;
+    }();
+    return picked;
+}
+
+__attribute__((target("sse4.1"))) std::size_t hex_encode_sse(const std::uint8_t* in, std::size_t n, char* out) {
+    const __m128i lut = _mm_setr_epi8('0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f');
+    const __m128i low = _mm_set1_epi8(0x0F);
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        const __m128i hi = _mm_shuffle_epi8(lut, _mm_and_si128(_mm_srli_epi16(v, 4), low));
+        const __m128i lo = _mm_shuffle_epi8(lut, _mm_and_si128(v, low));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i * 2), _mm_unpacklo_epi8(hi, lo));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i * 2 + 16), _mm_unpackhi_epi8(hi, lo));
+    }
+    return i;
+}
+
+__attribute__((target("avx2"))) std::size_t hex_encode_avx2(const std::uint8_t* in, std::size_t n, char* out) {
+    const __m256i lut = _mm256_setr_epi8('0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f', '0', '1', '2', '3', '4', '5', '6', '7', '8',
+                                         '9', 'a', 'b', 'c', 'd', 'e', 'f');
+    const __m256i low = _mm256_set1_epi8(0x0F);
+    std::size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+        const __m256i hi = _mm256_shuffle_epi8(lut, _mm256_and_si256(_mm256_srli_epi16(v, 4), low));
+        const __m256i lo = _mm256_shuffle_epi8(lut, _mm256_and_si256(v, low));
+        const __m256i a = _mm256_unpacklo_epi8(hi, lo);
+        const __m256i b = _mm256_unpackhi_epi8(hi, lo);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i * 2), _mm256_permute2x128_si256(a, b, 0x20));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i * 2 + 32), _mm256_permute2x128_si256(a, b, 0x31));
+    }
+    return i + hex_encode_sse(in + i, n - i, out + i * 2);
+}
+
+__attribute__((target("sse4.1"))) __m128i hex_nibbles_sse(__m128i c, __m128i& bad) {
+    const __m128i lower = _mm_or_si128(c, _mm_set1_epi8(0x20));
+    const __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8('0' - 1)), _mm_cmplt_epi8(c, _mm_set1_epi8('9' + 1)));
+    const __m128i alpha = _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)), _mm_cmplt_epi8(lower, _mm_set1_epi8('f' + 1)));
+    bad = _mm_or_si128(bad, _mm_andnot_si128(_mm_or_si128(digit, alpha), _mm_set1_epi8(-1)));
+    return _mm_add_epi8(_mm_and_si128(c, _mm_set1_epi8(0x0F)), _mm_and_si128(alpha, _mm_set1_epi8(9)));
+}
+
+__attribute__((target("sse4.1"))) std::size_t hex_decode_sse(const char* in, std::size_t n, std::uint8_t* out) {
+    const __m128i weights = _mm_set1_epi16(0x0110);
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i bad = _mm_setzero_si128();
+        const __m128i a = hex_nibbles_sse(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i * 2)), bad);
+        const __m128i b = hex_nibbles_sse(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i * 2 + 16)), bad);
+        if (!_mm_testz_si128(bad, bad)) {
+            die("invalid hex character");
+        }
+        const __m128i packed = _mm_packus_epi16(_mm_maddubs_epi16(a, weights), _mm_maddubs_epi16(b, weights));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), packed);
+    }
+    return i;
+}
+
+__attribute__((target("avx2"))) __m256i hex_nibbles_avx2(__m256i c, __m256i& bad) {
+    const __m256i lower = _mm256_or_si256(c, _mm256_set1_epi8(0x20));
+    const __m256i digit = _mm256_and_si256(_mm256_cmpgt_epi8(c, _mm256_set1_epi8('0' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), c));
+    const __m256i alpha = _mm256_and_si256(_mm256_cmpgt_epi8(lower, _mm256_set1_epi8('a' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('f' + 1), lower));
+    bad = _mm256_or_si256(bad, _mm256_andnot_si256(_mm256_or_si256(digit, alpha), _mm256_set1_epi8(-1)));
+    return _mm256_add_epi8(_mm256_and_si256(c, _mm256_set1_epi8(0x0F)), _mm256_and_si256(alpha, _mm256_set1_epi8(9)));
+}
+
+__attribute__((target("avx2"))) std::size_t hex_decode_avx2(const char* in, std::size_t n, std::uint8_t* out) {
+    const __m256i weights = _mm256_set1_epi16(0x0110);
+    std::size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i bad = _mm256_setzero_si256();
+        const __m256i a = hex_nibbles_avx2(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i * 2)), bad);
+        const __m256i b = hex_nibbles_avx2(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i * 2 + 32)), bad);
+        if (!_mm256_testz_si256(bad, bad)) {
+            die("invalid hex character");
+        }
+        const __m256i packed = _mm256_packus_epi16(_mm256_maddubs_epi16(a, weights), _mm256_maddubs_epi16(b, weights));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_permute4x64_epi64(packed, 0xD8));
+    }
+    return i + hex_decode_sse(in + i * 2, n - i, out + i);
+}
+
+__attribute__((target("sse4.1"))) std::size_t b64_encode_sse(const std::uint8_t* in, std::size_t n, char* out) {
+    const __m128i spread = _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1);
+    const __m128i shift = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+                                        '/' - 63, 'A', 0, 0);
+    std::size_t i = 0;
+    std::size_t o = 0;
+    for (; i + 16 <= n; i += 12, o += 16) {
+        const __m128i v = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i)), spread);
+        const __m128i t0 = _mm_mulhi_epu16(_mm_and_si128(v, _mm_set1_epi32(0x0FC0FC00)), _mm_set1_epi32(0x04000040));
+        const __m128i t1 = _mm_mullo_epi16(_mm_and_si128(v, _mm_set1_epi32(0x003F03F0)), _mm_set1_epi32(0x01000010));
+        const __m128i idx = _mm_or_si128(t0, t1);
+        __m128i sel = _mm_subs_epu8(idx, _mm_set1_epi8(51));
+        sel = _mm_or_si128(sel, _mm_and_si128(_mm_cmpgt_epi8(_mm_set1_epi8(26), idx), _mm_set1_epi8(13)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + o), _mm_add_epi8(_mm_shuffle_epi8(shift, sel), idx));
+    }
+    return i;
+}
+
+__attribute__((target("sse4.1"))) std::size_t b64_decode_sse(const char* in, std::size_t quads, std::uint8_t* out, std::size_t room) {
+    const __m128i lut_lo = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+    const __m128i lut_hi = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    const __m128i lut_roll = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m128i mask_2f = _mm_set1_epi8(0x2F);
+    const __m128i order = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+    std::size_t q = 0;
+    for (; q + 4 <= quads && q * 3 + 16 <= room; q += 4) {
+        const __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + q * 4));
+        const __m128i hi_nib = _mm_and_si128(_mm_srli_epi32(s, 4), mask_2f);
+        const __m128i hi = _mm_shuffle_epi8(lut_hi, hi_nib);
+        const __m128i lo = _mm_shuffle_epi8(lut_lo, _mm_and_si128(s, mask_2f));
+        if (!_mm_testz_si128(lo, hi)) {
+            die("invalid base64 character");
+        }
+        const __m128i roll = _mm_shuffle_epi8(lut_roll, _mm_add_epi8(_mm_cmpeq_epi8(s, mask_2f), hi_nib));
+        const __m128i vals = _mm_add_epi8(s, roll);
+        const __m128i ab_bc = _mm_maddubs_epi16(vals, _mm_set1_epi32(0x01400140));
+        const __m128i packed = _mm_madd_epi16(ab_bc, _mm_set1_epi32(0x00011000));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + q * 3), _mm_shuffle_epi8(packed, order));
+    }
+    return q;
+}
+
+std::size_t hex_encode_fast(const std::uint8_t* in, std::size_t n, char* out) {
+    switch (level()) {
+    case Level::avx2:
+        return hex_encode_avx2(in, n, out);
+    case Level::sse41:
+        return hex_encode_sse(in, n, out);
+    case Level::scalar:
+        break;
+    }
+    return 0;
+}
+
+std::size_t hex_decode_fast(const char* in, std::size_t n, std::uint8_t* out) {
+    switch (level()) {
+    case Level::avx2:
+        return hex_decode_avx2(in, n, out);
+    case Level::sse41:
+        return hex_decode_sse(in, n, out);
+    case Level::scalar:
+        break;
+    }
+    return 0;
+}
+
+std::size_t b64_encode_fast(const std::uint8_t* in, std::size_t n, char* out) {
+    return level() == Level::scalar ? 0 : b64_encode_sse(in, n, out);
+}
+
+std::size_t b64_decode_fast(const char* in, std::size_t quads, std::uint8_t* out, std::size_t room) {
+    return level() == Level::scalar ? 0 : b64_decode_sse(in, quads, out, room);
+}
+
+#elif defined(SYNCSTREAM_NEON)
+
+std::size_t hex_encode_fast(const std::uint8_t* in, std::size_t n, char* out) {
+    static const std::uint8_t digits[16] = {'0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f'};
+    const uint8x16_t lut = vld1q_u8(digits);
+    const uint8x16_t low = vdupq_n_u8(0x0F);
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        const uint8x16_t v = vld1q_u8(in + i);
+        uint8x16x2_t pair;
+        pair.val[0] = vqtbl1q_u8(lut, vshrq_n_u8(v, 4));
+        pair.val[1] = vqtbl1q_u8(lut, vandq_u8(v, low));
+        vst2q_u8(reinterpret_cast<std::uint8_t*>(out + i * 2), pair);
+    }
+    return i;
+}
+
+uint8x16_t hex_nibbles_neon(uint8x16_t c, uint8x16_t& ok) {
+    const uint8x16_t lower = vorrq_u8(c, vdupq_n_u8(0x20));
+    const uint8x16_t digit = vcleq_u8(vsubq_u8(c, vdupq_n_u8('0')), vdupq_n_u8(9));
+    const uint8x16_t alpha = vcleq_u8(vsubq_u8(lower, vdupq_n_u8('a')), vdupq_n_u8(5));
+    ok = vandq_u8(ok, vorrq_u8(digit, alpha));
+    return vaddq_u8(vandq_u8(c, vdupq_n_u8(0x0F)), vandq_u8(alpha, vdupq_n_u8(9)));
+}
+
+std::size_t hex_decode_fast(const char* in, std::size_t n, std::uint8_t* out) {
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        const uint8x16x2_t pair = vld2q_u8(reinterpret_cast<const std::uint8_t*>(in + i * 2));
+        uint8x16_t ok = vdupq_n_u8(0xFF);
+        const uint8x16_t hi = hex_nibbles_neon(pair.val[0], ok);
+        const uint8x16_t lo = hex_nibbles_neon(pair.val[1], ok);
+        if (vminvq_u8(ok) != 0xFF) {
+            die("invalid hex character");
+        }
+        vst1q_u8(out + i, vorrq_u8(vshlq_n_u8(hi, 4), lo));
+    }
+    return i;
+}
+
+std::size_t b64_encode_fast(const std::uint8_t*, std::size_t, char*) {
+    return 0;
+}
+
+std::size_t b64_decode_fast(const char*, std::size_t, std::uint8_t*, std::size_t) {
+    return 0;
+}
+
+#else
+
+std::size_t hex_encode_fast(const std::uint8_t*, std::size_t, char*) {
+    return 0;
+}
+
+std::size_t hex_decode_fast(const char*, std::size_t, std::uint8_t*) {
+    return 0;
+}
+
+std::size_t b64_encode_fast(const std::uint8_t*, std::size_t, char*) {
+    return 0;
+}
+
+std::size_t b64_decode_fast(const char*, std::size_t, std::uint8_t*, std::size_t) {
+    return 0;
+}
+
+#endif
+
+}
+
+std::size_t hex_encode(std::span<const std::uint8_t> in, std::span<char> out) {
+    if (out.size() < hex_len(in.size())) {
+        die("output buffer too small");
+    }
+    const auto done = hex_encode_fast(in.data(), in.size(), out.data());
+    hex_encode_tail(in.data() + done, in.size() - done, out.data() + done * 2);
+    return hex_len(in.size());
+}
+
+std::size_t hex_decode(std::string_view in, std::span<std::uint8_t> out) {
+    if ((in.size() % 2U) != 0U) {
+        die("hex input must have even length");
+    }
+    const auto n = in.size() / 2U;
+    if (out.size() < n) {
+        die("output buffer too small");
+    }
+    const auto done = hex_decode_fast(in.data(), n, out.data());
+    hex_decode_tail(in.data() + done * 2, n - done, out.data() + done);
+    return n;
+}
+
+std::size_t b64_encode(std::span<const std::uint8_t> in, std::span<char> out) {
+    if (out.size() < b64_len(in.size())) {
+        die("output buffer too small");
+    }
+    const auto done = b64_encode_fast(in.data(), in.size(), out.data());
+    return done / 3 * 4 + b64_encode_tail(in.data() + done, in.size() - done, out.data() + done / 3 * 4);
+}
+
+std::size_t b64_decode(std::string_view in, std::span<std::uint8_t> out) {
+    if ((in.size() % 4U) != 0U) {
+        die("base64 input length invalid");
+    }
+    if (in.empty()) {
+        return 0;
+    }
+
+    const std::size_t pad = in[in.size() - 1] == '=' ? (in[in.size() - 2] == '=' ? 2U : 1U) : 0U;
+    const auto quads = in.size() / 4U - 1U;
+    const auto n = in.size() / 4U * 3U - pad;
+    if (out.size() < n) {
+        die("output buffer too small");
+    }
+
+    const auto fast = b64_decode_fast(in.data(), quads, out.data(), n);
+    b64_decode_quads(in.data() + fast * 4, quads - fast, out.data() + fast * 3);
+
+    std::array<char, 4> last{};
+    for (std::size_t i = 0; i < 4; ++i) {
+        last[i] = i < 4 - pad ? in[quads * 4 + i] : 'A';
+    }
+    std::array<std::uint8_t, 3> tail{};
+    b64_decode_quads(last.data(), 1, tail.data());
+    const auto lead = b64_val[static_cast<unsigned char>(last[4 - pad - 1])];
+    if ((pad == 1 && (lead & 0x03) != 0) || (pad == 2 && (lead & 0x0F) != 0)) {
+        die("base64 padding bits set");
+    }
+    for (std::size_t i = 0; i < 3 - pad; ++i) {
+        out[quads * 3 + i] = tail[i];
+    }
+    return n;
+}
+
+std::string b64_of(std::span<const std::uint8_t> data) {
+    std::string out(b64_len(data.size()), '\0');
+    b64_encode(data, out);
+    return out;
+}
+
+std::vector<std::uint8_t> from_b64(std::string_view text) {
+    std::vector<std::uint8_t> out(text.size() / 4U * 3U);
+    out.resize(b64_decode(text, out));
+    return out;
+}
+
+const char* codec_path() {
+#if defined(SYNCSTREAM_X86)
+    switch (level()) {
+    case Level::avx2:
+        return "avx2";
+    case Level::sse41:
+        return "sse4.1";
+    case Level::scalar:
+        break;
+    }
+    return "scalar";
+#elif defined(SYNCSTREAM_NEON)
+    return "neon";
+#else
+    return "scalar";
+#endif
+}
+
+}
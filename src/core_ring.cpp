@@ -0,0 +1,90 @@
+#include "syncstream/core_ring.hpp"
+
+#include <openssl/crypto.h>
+
+#include <stdexcept>
+
+namespace syncstream {
+namespace {
+
+[[noreturn]] void die(const std::string& msg) {
+    throw std::runtime_error(msg);
+}
+
+}
+
+CoreRing::CoreRing(Keychain& keys, std::chrono::milliseconds overlap, Build build) : keys_(keys), overlap_(0), build_(std::move(build)) {
+    if (overlap.count() < 0) {
+        die("overlap cannot be negative");
+    }
+    if (!build_) {
+        die("core builder missing");
+    }
+    overlap_ = static_cast<std::uint64_t>(overlap.count());
+}
+
+void CoreRing::stage(std::uint32_t ver, Suite suite, std::shared_ptr<RelayCore> core) {
+    if (!slots_.try_emplace(ver, Slot{suite, std::move(core), 0}).second) {
+        die("key version already staged");
+    }
+}
+
+void CoreRing::activate(std::uint32_t ver, std::uint64_t now) {
+    auto it = slots_.find(ver);
+    if (it == slots_.end()) {
+        die("key version not staged");
+    }
+    keys_.activate(ver);
+    it->second.retire_at = 0;
+    for (auto& kv : slots_) {
+        if (kv.first != ver && kv.second.retire_at == 0 && (kv.first < ver || kv.first == live_)) {
+            kv.second.retire_at = now + overlap_;
+        }
+    }
+    live_ = ver;
+    static_cast<void>(reap(now));
+}
+
+std::shared_ptr<RelayCore> CoreRing::core_for(std::uint32_t ver, std::uint64_t now) {
+    auto it = slots_.find(ver);
+    if (it == slots_.end()) {
+        die("key version unknown");
+    }
+    if (it->second.retire_at != 0 && now >= it->second.retire_at) {
+        static_cast<void>(reap(now));
+        die("key version retired");
+    }
+    if (!it->second.core) {
+        auto key = keys_.take(ver);
+        try {
+            it->second.core = build_(key, it->second.suite);
+        } catch (...) {
+            OPENSSL_cleanse(key.data(), key.size());
+            throw;
+        }
+        OPENSSL_cleanse(key.data(), key.size());
+    }
+    return it->second.core;
+}
+
+std::size_t CoreRing::built() const {
+    std::size_t n = 0;
+    each([&](const RelayCore&) { ++n; });
+    return n;
+}
+
+std::size_t CoreRing::reap(std::uint64_t now) {
+    std::size_t gone = 0;
+    for (auto it = slots_.begin(); it != slots_.end();) {
+        if (it->second.retire_at != 0 && now >= it->second.retire_at) {
+            keys_.drop(it->first);
+            it = slots_.erase(it);
+            ++gone;
+        } else {
+            ++it;
+        }
+    }
+    return gone;
+}
+
+}
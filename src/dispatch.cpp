@@ -0,0 +1,190 @@
+#include "syncstream/dispatch.hpp"
+
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace syncstream {
+namespace {
+
+[[noreturn]] void die(const std::string& msg) {
+    throw std::runtime_error(msg);
+}
+
+std::uint64_t control_law(std::uint64_t t, std::uint64_t interval, std::uint32_t count) {
+    return t + static_cast<std::uint64_t>(static_cast<double>(interval) / std::sqrt(static_cast<double>(count)));
+}
+
+}
+
+Prio prio_of(Cmd cmd) {
+    switch (cmd) {
+    case Cmd::arm:
+    case Cmd::disarm:
+        return Prio::critical;
+    case Cmd::ping:
+    case Cmd::beats:
+        return Prio::bulk;
+    default:
+        return Prio::normal;
+    }
+}
+
+const char* shed_name(Shed why) {
+    switch (why) {
+    case Shed::none:
+        return "none";
+    case Shed::queue_full:
+        return "queue full";
+    case Shed::delay:
+        return "queue delay";
+    case Shed::stale:
+        return "stale at dequeue";
+    }
+    return "unknown";
+}
+
+Dispatcher::Dispatcher(DispatchConfig cfg) : cfg_(cfg) {
+    if (cfg_.depth == 0 || cfg_.target.count() <= 0 || cfg_.interval.count() <= 0) {
+        die("dispatch config invalid");
+    }
+    for (const auto w : cfg_.weights) {
+        if (w == 0) {
+            die("dispatch weight cannot be zero");
+        }
+    }
+}
+
+Shed Dispatcher::push(Ctrl ctrl, std::uint64_t now) {
+    std::scoped_lock lock(mu_);
+    const auto idx = static_cast<std::size_t>(prio_of(ctrl.cmd));
+    auto& lane = lanes_[idx];
+    if (lane.q.size() >= cfg_.depth) {
+        ++lane.stats.shed_full;
+        return Shed::queue_full;
+    }
+    if (idx != static_cast<std::size_t>(Prio::critical)) {
+        for (std::size_t j = 0; j <= idx; ++j) {
+            if (lanes_[j].dropping) {
+                ++lane.stats.shed_delay;
+                return Shed::delay;
+            }
+        }
+    }
+    lane.q.push_back(Item{std::move(ctrl), now});
+    ++lane.stats.admitted;
+    return Shed::none;
+}
+
+bool Dispatcher::over_target(Lane& lane, std::uint64_t sojourn, std::uint64_t now) {
+    const auto target = static_cast<std::uint64_t>(cfg_.target.count());
+    if (sojourn < target || lane.q.empty()) {
+        lane.first_above = 0;
+        return false;
+    }
+    if (lane.first_above == 0) {
+        lane.first_above = now + static_cast<std::uint64_t>(cfg_.interval.count());
+        return false;
+    }
+    return now >= lane.first_above;
+}
+
+std::optional<Ctrl> Dispatcher::take(Lane& lane, std::uint64_t now) {
+    const auto interval = static_cast<std::uint64_t>(cfg_.interval.count());
+    const bool shield = &lane == &lanes_[static_cast<std::size_t>(Prio::critical)];
+    while (!lane.q.empty()) {
+        Item item = std::move(lane.q.front());
+        lane.q.pop_front();
+        const std::uint64_t sojourn = now >= item.enq ? now - item.enq : 0;
+        const bool over = over_target(lane, sojourn, now);
+
+        if (lane.dropping) {
+            if (!over) {
+                lane.dropping = false;
+            } else if (!shield && now >= lane.drop_next) {
+                ++lane.stats.shed_stale;
+                ++lane.count;
+                lane.drop_next = control_law(lane.drop_next, interval, lane.count);
+                continue;
+            }
+        } else if (over) {
+            lane.dropping = true;
+            lane.count = (lane.count > 2 && now < lane.drop_next + 8 * interval) ? lane.count - 2 : 1;
+            lane.drop_next = control_law(now, interval, lane.count);
+            if (!shield) {
+                ++lane.stats.shed_stale;
+                continue;
+            }
+        }
+
+        ++lane.stats.served;
+        if (sojourn > lane.stats.max_wait_ms) {
+            lane.stats.max_wait_ms = sojourn;
+        }
+        return std::move(item.ctrl);
+    }
+    lane.dropping = false;
+    lane.first_above = 0;
+    return std::nullopt;
+}
+
+std::size_t Dispatcher::pick() {
+    if (!lanes_[static_cast<std::size_t>(Prio::critical)].q.empty()) {
+        return static_cast<std::size_t>(Prio::critical);
+    }
+    if (cfg_.strict) {
+        for (std::size_t i = 1; i < prio_count; ++i) {
+            if (!lanes_[i].q.empty()) {
+                return i;
+            }
+        }
+        return prio_count;
+    }
+    for (int pass = 0; pass < 2; ++pass) {
+        auto& lane = lanes_[turn_];
+        if (!lane.q.empty() && lane.credit < cfg_.weights[turn_]) {
+            ++lane.credit;
+            return turn_;
+        }
+        lane.credit = 0;
+        turn_ = turn_ == 1 ? 2 : 1;
+    }
+    auto& lane = lanes_[turn_];
+    if (!lane.q.empty()) {
+        ++lane.credit;
+        return turn_;
+    }
+    return prio_count;
+}
+
+std::optional<Ctrl> Dispatcher::pop(std::uint64_t now) {
+    std::scoped_lock lock(mu_);
+    for (;;) {
+        const auto idx = pick();
+        if (idx == prio_count) {
+            return std::nullopt;
+        }
+        auto out = take(lanes_[idx], now);
+        if (out) {
+            return out;
+        }
+    }
+}
+
+std::size_t Dispatcher::depth(Prio prio) const {
+    std::scoped_lock lock(mu_);
+    return lanes_[static_cast<std::size_t>(prio)].q.size();
+}
+
+bool Dispatcher::dropping(Prio prio) const {
+    std::scoped_lock lock(mu_);
+    return lanes_[static_cast<std::size_t>(prio)].dropping;
+}
+
+ClassStats Dispatcher::stats(Prio prio) const {
+    std::scoped_lock lock(mu_);
+    return lanes_[static_cast<std::size_t>(prio)].stats;
+}
+
+}
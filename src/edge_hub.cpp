@@ -1,5 +1,7 @@
 #include "syncstream/edge_hub.hpp"
 
+#include <openssl/crypto.h>
+
 #include <algorithm>
 #include <cmath>
 #include <stdexcept>
@@ -13,19 +15,33 @@ namespace {
 
 }
 
-RateGate::RateGate(std::size_t burst, std::size_t refill_per_sec) : burst_(burst), refill_(refill_per_sec) {
-    if (burst_ == 0 || refill_ == 0) {
+RateGate::RateGate(std::size_t burst, std::size_t refill_per_sec, std::chrono::milliseconds idle) : burst_(burst), refill_(refill_per_sec), idle_(0) {
+    if (burst_ == 0 || refill_ == 0 || idle.count() <= 0) {
         die("rate gate config invalid");
     }
+    idle_ = static_cast<std::uint64_t>(idle.count());
 }
 
-bool RateGate::hit(const std::string& dev, std::uint64_t now) {
+bool RateGate::hit(std::string_view dev, std::uint64_t now) {
     std::scoped_lock lock(mu_);
-    auto& b = slots_[dev];
-    if (b.last == 0) {
-        b.tok = static_cast<double>(burst_);
-        b.last = now;
+    return charge(dev, now);
+}
+
+Task<bool> RateGate::hit_async(std::string dev, std::uint64_t now, Executor& ex) {
+    const auto lock = co_await mu_.lock(ex);
+    co_return charge(dev, now);
+}
+
+bool RateGate::charge(std::string_view dev, std::uint64_t now) {
+    if (now >= next_sweep_) {
+        sweep(now);
+        next_sweep_ = now + idle_;
+    }
+    auto it = slots_.find(dev);
+    if (it == slots_.end()) {
+        it = slots_.emplace(std::string(dev), Bucket{static_cast<double>(burst_), now}).first;
     }
+    auto& b = it->second;
     const std::uint64_t dt = now >= b.last ? now - b.last : 0;
     const double fill = static_cast<double>(dt) / 1000.0 * static_cast<double>(refill_);
     b.tok = std::min(static_cast<double>(burst_), b.tok + fill);
@@ -37,6 +53,27 @@ bool RateGate::hit(const std::string& dev, std::uint64_t now) {
     return true;
 }
 
+void RateGate::sweep(std::uint64_t now) {
+    std::erase_if(slots_, [&](const auto& kv) {
+        const auto& b = kv.second;
+        if (now < b.last || now - b.last < idle_) {
+            return false;
+        }
+        const double fill = static_cast<double>(now - b.last) / 1000.0 * static_cast<double>(refill_);
+        return b.tok + fill >= static_cast<double>(burst_);
+    });
+}
+
+bool RateGate::knows(std::string_view dev) const {
+    std::scoped_lock lock(mu_);
+    return slots_.find(dev) != slots_.end();
+}
+
+std::size_t RateGate::size() const {
+    std::scoped_lock lock(mu_);
+    return slots_.size();
+}
+
 void PolicyGate::allow(Cmd cmd) {
     allow_.insert(static_cast<std::uint8_t>(cmd));
 }
@@ -45,59 +82,235 @@ bool PolicyGate::can(Cmd cmd) const {
     return allow_.find(static_cast<std::uint8_t>(cmd)) != allow_.end();
 }
 
-EdgeHub::EdgeHub(std::array<std::uint8_t, key_len> master, std::chrono::milliseconds max_skew, std::size_t replay_cap, std::size_t burst, std::size_t refill_per_sec)
-    : keychain_(master), max_skew_(max_skew), replay_cap_(replay_cap), rate_(burst, refill_per_sec) {}
+EdgeHub::EdgeHub(std::array<std::uint8_t, key_len> master, std::chrono::milliseconds max_skew, std::size_t replay_hint, std::size_t burst, std::size_t refill_per_sec,
+                 std::chrono::milliseconds overlap, std::shared_ptr<const Clock> clock)
+    : keychain_(master),
+      clock_(std::move(clock)),
+      max_skew_(max_skew),
+      replay_hint_(replay_hint),
+      rate_(burst, refill_per_sec),
+      ring_(keychain_, overlap, [this](const std::array<std::uint8_t, key_len>& key, Suite suite) { return build(key, suite); }) {
+    if (!clock_) {
+        die("clock missing");
+    }
+}
 
-void EdgeHub::stage_key(std::uint32_t ver, std::span<const std::uint8_t> salt, std::span<const std::uint8_t> ctx, bool activate_now) {
-    keychain_.stage(ver, salt, ctx);
+std::shared_ptr<RelayCore> EdgeHub::build(const std::array<std::uint8_t, key_len>& key, Suite suite) const {
+    auto core = std::make_shared<RelayCore>(key, max_skew_, replay_hint_, clock_, suite);
+    core->track_clocks(clocks_);
+    core->strict_bodies(strict_);
+    return core;
+}
+
+void EdgeHub::stage_key(std::uint32_t ver, std::span<const std::uint8_t> salt, std::span<const std::uint8_t> ctx, bool activate_now, Suite suite) {
+    auto secret = keychain_.derive(salt, ctx);
+    std::array<std::uint8_t, key_len> key{};
+    std::copy_n(secret.view().begin(), key_len, key.begin());
+    {
+        std::scoped_lock lock(mu_);
+        if (keychain_.has(ver)) {
+            OPENSSL_cleanse(key.data(), key.size());
+            die("key version already staged");
+        }
+        std::shared_ptr<RelayCore> core;
+        try {
+            core = build(key, suite);
+        } catch (...) {
+            OPENSSL_cleanse(key.data(), key.size());
+            throw;
+        }
+        OPENSSL_cleanse(key.data(), key.size());
+        keychain_.stage(ver, std::move(secret), suite);
+        ring_.stage(ver, suite, std::move(core));
+    }
     if (activate_now) {
-        keychain_.activate(ver);
+        activate_key(ver);
     }
 }
 
+void EdgeHub::activate_key(std::uint32_t ver) {
+    const auto now = clock_->now_ms();
+    std::scoped_lock lock(mu_);
+    ring_.activate(ver, now);
+}
+
+std::size_t EdgeHub::retire_due() {
+    const auto now = clock_->now_ms();
+    std::scoped_lock lock(mu_);
+    return ring_.reap(now);
+}
+
+std::size_t EdgeHub::live_versions() const {
+    std::scoped_lock lock(mu_);
+    return ring_.size();
+}
+
 void EdgeHub::allow_cmd(Cmd cmd) {
     policy_.allow(cmd);
 }
 
-RelayCore& EdgeHub::core_for(std::uint32_t ver) {
+void EdgeHub::track_clocks(std::shared_ptr<ClockTracker> clocks) {
     std::scoped_lock lock(mu_);
-    auto it = cores_.find(ver);
-    if (it != cores_.end()) {
-        return *(it->second);
-    }
-    const auto key = keychain_.take(ver);
-    auto core = std::make_unique<RelayCore>(key, max_skew_, replay_cap_);
-    auto [pos, ok] = cores_.emplace(ver, std::move(core));
-    if (!ok) {
-        die("core map insert failed");
-    }
-    return *(pos->second);
+    ring_.each([&](RelayCore& core) { core.track_clocks(clocks); });
+    clocks_ = std::move(clocks);
+}
+
+void EdgeHub::strict_bodies(bool on) {
+    std::scoped_lock lock(mu_);
+    ring_.each([&](RelayCore& core) { core.strict_bodies(on); });
+    strict_ = on;
+}
+
+void EdgeHub::track_presence(std::shared_ptr<PresenceTable> presence) {
+    presence_.store(std::move(presence), std::memory_order_release);
+}
+
+std::shared_ptr<RelayCore> EdgeHub::core_for(std::uint32_t ver, std::uint64_t now) {
+    std::scoped_lock lock(mu_);
+    return ring_.core_for(ver, now);
+}
+
+Task<std::shared_ptr<RelayCore>> EdgeHub::core_for_async(std::uint32_t ver, std::uint64_t now, Executor& ex) {
+    const auto lock = co_await mu_.lock(ex);
+    co_return ring_.core_for(ver, now);
 }
 
 VersionedEnv EdgeHub::seal(const Ctrl& ctrl) {
     if (!policy_.can(ctrl.cmd)) {
         die("cmd not allowed");
     }
-    const auto now = now_ms();
-    if (!rate_.hit(ctrl.dev, now)) {
+    const auto now = clock_->now_ms();
+    if (!rate_.hit(ctrl.dev.str(), now)) {
         die("rate limited");
     }
     const auto ver = keychain_.active();
-    auto& core = core_for(ver);
-    return VersionedEnv{ver, core.seal_ctrl(ctrl)};
+    const auto core = core_for(ver, now);
+    return VersionedEnv{ver, core->seal_ctrl(ctrl)};
 }
 
 Ctrl EdgeHub::open(const VersionedEnv& env) {
-    auto& core = core_for(env.key_ver);
-    const auto ctrl = core.open_ctrl(env.env);
+    return open_at(env, clock_->now_ms());
+}
+
+Ctrl EdgeHub::open_at(const VersionedEnv& env, std::uint64_t now) {
+    const auto core = core_for(env.key_ver, now);
+    const auto ctrl = core->open_ctrl(env.env, now);
     if (!policy_.can(ctrl.cmd)) {
         die("cmd not allowed");
     }
-    const auto now = now_ms();
-    if (!rate_.hit(ctrl.dev, now)) {
+    if (!rate_.hit(ctrl.dev.str(), now)) {
         die("rate limited");
     }
+    feed(ctrl, now);
     return ctrl;
 }
 
+void EdgeHub::feed(const Ctrl& ctrl, std::uint64_t now) {
+    if (ctrl.cmd == Cmd::beats) {
+        static_cast<void>(fan_out(ctrl, now));
+    }
+    if (ctrl.cmd == Cmd::ping || ctrl.cmd == Cmd::sync || ctrl.cmd == Cmd::sync_delta) {
+        if (const auto presence = presence_.load(std::memory_order_acquire)) {
+            presence->seen(ctrl.dev.str(), now);
+        }
+    }
+}
+
+std::size_t EdgeHub::fan_out(const Ctrl& batch, std::uint64_t now) {
+    const auto skew = static_cast<std::uint64_t>(max_skew_.count());
+    const auto beats = unpack_beats(batch.body.view());
+    const auto presence = presence_.load(std::memory_order_acquire);
+    if (!presence) {
+        return 0;
+    }
+    std::size_t applied = 0;
+    for (const auto& beat : beats) {
+        const auto gap = beat.at_ms > now ? beat.at_ms - now : now - beat.at_ms;
+        if (gap <= skew && presence->seen(beat.dev.str(), std::min(beat.at_ms, now))) {
+            ++applied;
+        }
+    }
+    return applied;
+}
+
+std::optional<std::uint64_t> EdgeHub::last_seen(std::string_view dev) const {
+    const auto presence = presence_.load(std::memory_order_acquire);
+    if (!presence) {
+        return std::nullopt;
+    }
+    return presence->last_seen(dev);
+}
+
+void EdgeHub::coalesce(std::chrono::milliseconds window) {
+    auto next = std::make_shared<Coalescer>(window);
+    std::scoped_lock lock(mu_);
+    if (coal_ && coal_->pending() != 0) {
+        die("coalescer has pending commands");
+    }
+    coal_ = std::move(next);
+}
+
+std::shared_ptr<Coalescer> EdgeHub::coalescer() const {
+    std::scoped_lock lock(mu_);
+    if (!coal_) {
+        die("coalescing not enabled");
+    }
+    return coal_;
+}
+
+void EdgeHub::submit(const VersionedEnv& env) {
+    static_cast<void>(coalescer());
+    const auto now = clock_->now_ms();
+    auto ctrl = open_at(env, now);
+    std::scoped_lock lock(mu_);
+    coal_->push(std::move(ctrl), now);
+}
+
+std::vector<Ctrl> EdgeHub::drain() {
+    return coalescer()->drain(clock_->now_ms());
+}
+
+CoalesceStats EdgeHub::coalesce_stats() const {
+    std::scoped_lock lock(mu_);
+    return coal_ ? coal_->stats() : CoalesceStats{};
+}
+
+Task<VersionedEnv> EdgeHub::seal_async(Ctrl ctrl, Executor& ex) {
+    if (!policy_.can(ctrl.cmd)) {
+        die("cmd not allowed");
+    }
+    const auto now = clock_->now_ms();
+    if (!co_await rate_.hit_async(std::string(ctrl.dev.str()), now, ex)) {
+        die("rate limited");
+    }
+    const auto ver = keychain_.active();
+    const auto core = co_await core_for_async(ver, now, ex);
+    co_return VersionedEnv{ver, core->seal_ctrl(ctrl)};
+}
+
+Task<Ctrl> EdgeHub::open_async(VersionedEnv env, Executor& ex) {
+    const auto now = clock_->now_ms();
+    const auto core = co_await core_for_async(env.key_ver, now, ex);
+    auto ctrl = co_await core->open_async(std::move(env.env), now, ex);
+    if (!policy_.can(ctrl.cmd)) {
+        die("cmd not allowed");
+    }
+    if (!co_await rate_.hit_async(std::string(ctrl.dev.str()), now, ex)) {
+        die("rate limited");
+    }
+    feed(ctrl, now);
+    co_return ctrl;
+}
+
+Task<> EdgeHub::stage_key_async(std::uint32_t ver, std::vector<std::uint8_t> salt, std::vector<std::uint8_t> ctx, bool activate_now, Executor& ex, Suite suite) {
+    co_await ex.schedule();
+    stage_key(ver, salt, ctx, activate_now, suite);
+}
+
+Task<std::vector<Ctrl>> EdgeHub::drain_async(Executor& ex) {
+    const auto gate = co_await flush_gate_.lock(ex);
+    co_await ex.schedule();
+    co_return drain();
+}
+
 }
@@ -4,6 +4,7 @@
 #include <openssl/evp.h>
 #include <openssl/kdf.h>
 
+#include <algorithm>
 #include <stdexcept>
 
 namespace syncstream {
@@ -27,22 +28,7 @@ void chk(int code, const char* msg) {
 
 }
 
-Keychain::Keychain(std::array<std::uint8_t, key_len> master) : master_(master) {}
-
-Keychain::~Keychain() {
-    clean(master_);
-    std::scoped_lock lock(mu_);
-    for (auto& [_, key] : slots_) {
-        clean(key);
-    }
-}
-
-void Keychain::stage(std::uint32_t ver, std::span<const std::uint8_t> salt, std::span<const std::uint8_t> ctx) {
-    if (ver == 0) {
-        die("key version cannot be zero");
-    }
-
-    std::array<std::uint8_t, key_len> out{};
+void hkdf_sha256(std::span<const std::uint8_t> ikm, std::span<const std::uint8_t> salt, std::span<const std::uint8_t> info, std::span<std::uint8_t> out) {
     EVP_KDF* kdf = EVP_KDF_fetch(nullptr, "HKDF", nullptr);
     if (!kdf) {
         die("hkdf fetch failed");
@@ -56,17 +42,44 @@ void Keychain::stage(std::uint32_t ver, std::span<const std::uint8_t> salt, std:
 
     OSSL_PARAM params[] = {
         OSSL_PARAM_construct_utf8_string("digest", const_cast<char*>("SHA256"), 0),
-        OSSL_PARAM_construct_octet_string("key", master_.data(), master_.size()),
+        OSSL_PARAM_construct_octet_string("key", const_cast<unsigned char*>(ikm.data()), ikm.size()),
         OSSL_PARAM_construct_octet_string("salt", const_cast<unsigned char*>(salt.data()), salt.size()),
-        OSSL_PARAM_construct_octet_string("info", const_cast<unsigned char*>(ctx.data()), ctx.size()),
+        OSSL_PARAM_construct_octet_string("info", const_cast<unsigned char*>(info.data()), info.size()),
         OSSL_PARAM_construct_end()};
 
     const int ok = EVP_KDF_derive(kctx, out.data(), out.size(), params);
     EVP_KDF_CTX_free(kctx);
     chk(ok, "hkdf derive failed");
+}
+
+Keychain::Keychain(std::array<std::uint8_t, key_len> master) : master_(SecureBlob::copy_of(master)) {
+    clean(master);
+}
+
+Keychain::~Keychain() = default;
+
+SecureBlob Keychain::derive(std::span<const std::uint8_t> salt, std::span<const std::uint8_t> ctx) const {
+    SecureBlob out(key_len);
+    hkdf_sha256(master_.view(), salt, ctx, out.bytes());
+    return out;
+}
+
+void Keychain::stage(std::uint32_t ver, std::span<const std::uint8_t> salt, std::span<const std::uint8_t> ctx, Suite suite) {
+    stage(ver, derive(salt, ctx), suite);
+}
+
+void Keychain::stage(std::uint32_t ver, SecureBlob key, Suite suite) {
+    if (ver == 0) {
+        die("key version cannot be zero");
+    }
+    if (key.size() != key_len) {
+        die("key length invalid");
+    }
 
     std::scoped_lock lock(mu_);
-    slots_[ver] = out;
+    if (!slots_.try_emplace(ver, Slot{std::move(key), suite}).second) {
+        die("key version already staged");
+    }
 }
 
 void Keychain::activate(std::uint32_t ver) {
@@ -77,13 +90,41 @@ void Keychain::activate(std::uint32_t ver) {
     active_ = ver;
 }
 
+void Keychain::drop(std::uint32_t ver) {
+    std::scoped_lock lock(mu_);
+    if (ver == active_) {
+        die("cannot drop active key");
+    }
+    const auto it = slots_.find(ver);
+    if (it == slots_.end()) {
+        return;
+    }
+    slots_.erase(it);
+}
+
 std::array<std::uint8_t, key_len> Keychain::take(std::uint32_t ver) const {
     std::scoped_lock lock(mu_);
     const auto it = slots_.find(ver);
     if (it == slots_.end()) {
         die("key version unknown");
     }
-    return it->second;
+    std::array<std::uint8_t, key_len> key{};
+    std::copy_n(it->second.key.view().begin(), key_len, key.begin());
+    return key;
+}
+
+Suite Keychain::suite(std::uint32_t ver) const {
+    std::scoped_lock lock(mu_);
+    const auto it = slots_.find(ver);
+    if (it == slots_.end()) {
+        die("key version unknown");
+    }
+    return it->second.suite;
+}
+
+bool Keychain::has(std::uint32_t ver) const {
+    std::scoped_lock lock(mu_);
+    return slots_.find(ver) != slots_.end();
 }
 
 std::uint32_t Keychain::active() const {
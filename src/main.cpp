@@ -1,9 +1,22 @@
+#include "syncstream/capture.hpp"
 #include "syncstream/secure_channel.hpp"
 #include <algorithm>
 
+#if defined(__unix__) || defined(__APPLE__)
+#define SYNCSTREAM_POSIX_MAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 #include <array>
+#include <chrono>
 #include <cstdint>
+#include <fstream>
 #include <iostream>
+#include <iterator>
+#include <span>
 #include <stdexcept>
 #include <string>
 #include <vector>
@@ -24,6 +37,114 @@ std::vector<std::uint8_t> bytes_of(const std::string& text) {
     return std::vector<std::uint8_t>(text.begin(), text.end());
 }
 
+syncstream::VerifyKey verify_key_of(const std::string& spec) {
+    const auto colon = spec.find(':');
+    if (colon == std::string::npos) {
+        throw std::runtime_error("key spec must be <ver>:<hex_key>[:<suite>]");
+    }
+    syncstream::VerifyKey out{};
+    out.ver = static_cast<std::uint32_t>(std::stoul(spec.substr(0, colon)));
+    const auto rest = spec.substr(colon + 1);
+    const auto tail = rest.find(':');
+    out.key = key_from_hex(rest.substr(0, tail));
+    if (tail != std::string::npos) {
+        const auto name = rest.substr(tail + 1);
+        if (name == "chacha" || name == syncstream::suite_name(syncstream::Suite::chacha_poly)) {
+            out.suite = syncstream::Suite::chacha_poly;
+        } else if (name != syncstream::suite_name(syncstream::Suite::aes_gcm)) {
+            throw std::runtime_error("unknown suite in key spec");
+        }
+    }
+    return out;
+}
+
+#if defined(SYNCSTREAM_POSIX_MAP)
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path) {
+        const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            throw std::runtime_error("cannot open capture");
+        }
+        struct stat st {};
+        if (::fstat(fd, &st) != 0) {
+            ::close(fd);
+            throw std::runtime_error("cannot stat capture");
+        }
+        len_ = static_cast<std::size_t>(st.st_size);
+        if (len_ != 0) {
+            void* p = ::mmap(nullptr, len_, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p == MAP_FAILED) {
+                ::close(fd);
+                throw std::runtime_error("cannot map capture");
+            }
+            static_cast<void>(::madvise(p, len_, MADV_SEQUENTIAL));
+            base_ = static_cast<std::uint8_t*>(p);
+        }
+        ::close(fd);
+    }
+    ~MappedFile() {
+        if (base_) {
+            ::munmap(base_, len_);
+        }
+    }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    std::span<const std::uint8_t> view() const { return {base_, len_}; }
+
+private:
+    std::uint8_t* base_ = nullptr;
+    std::size_t len_ = 0;
+};
+#else
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) {
+            throw std::runtime_error("cannot open capture");
+        }
+        data_.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+
+    std::span<const std::uint8_t> view() const { return data_; }
+
+private:
+    std::vector<std::uint8_t> data_;
+};
+#endif
+
+int run_verify(int argc, char** argv) {
+    std::vector<syncstream::VerifyKey> keys;
+    std::size_t threads = 0;
+    for (int i = 4; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--threads" && i + 1 < argc) {
+            threads = static_cast<std::size_t>(std::stoul(argv[++i]));
+        } else {
+            keys.push_back(verify_key_of(arg));
+        }
+    }
+    if (keys.empty()) {
+        throw std::runtime_error("verify needs at least one key");
+    }
+
+    const MappedFile file(argv[2]);
+    const auto skew = std::chrono::milliseconds(std::stoll(argv[3]));
+    const auto report = syncstream::verify_capture(file.view(), keys, skew, threads);
+
+    for (const auto& f : report.faults) {
+        std::cout << "record=" << f.index << " offset=" << f.offset << " fault=" << syncstream::fault_name(f.why) << '\n';
+    }
+    std::cout << "total=" << report.total << " ok=" << report.ok;
+    for (std::size_t i = 1; i < report.by_fault.size(); ++i) {
+        std::cout << ' ' << syncstream::fault_name(static_cast<syncstream::Fault>(i)) << '=' << report.by_fault[i];
+    }
+    std::cout << '\n';
+    return report.ok == report.total ? 0 : 3;
+}
+
 }
 
 int main(int argc, char** argv) {
@@ -34,10 +155,15 @@ int main(int argc, char** argv) {
             return 0;
         }
 
+        if (argc >= 5 && std::string(argv[1]) == "verify") {
+            return run_verify(argc, argv);
+        }
+
         if (argc != 4) {
             std::cerr << "Usage:\n";
             std::cerr << "  syncstream_cli gen\n";
             std::cerr << "  syncstream_cli <hex_key> <aad> <message>\n";
+            std::cerr << "  syncstream_cli verify <capture> <skew_ms> <ver>:<hex_key>[:<suite>]... [--threads n]\n";
             return 1;
         }
 
@@ -49,6 +175,7 @@ int main(int argc, char** argv) {
         const syncstream::Packet pack = rig.seal(plain, aad);
         const syncstream::SecureBlob out = rig.open(pack, aad);
 
+        std::cout << "suite=" << syncstream::suite_name(rig.suite()) << '\n';
         std::cout << "nonce=" << syncstream::hex_of(pack.nonce) << '\n';
         std::cout << "cipher=" << syncstream::hex_of(pack.body) << '\n';
         std::cout << "tag=" << syncstream::hex_of(pack.mac) << '\n';
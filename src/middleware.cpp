@@ -1,4 +1,6 @@
 #include "syncstream/middleware.hpp"
+#include "syncstream/clock_sync.hpp"
+#include "syncstream/schema.hpp"
 
 #include <algorithm>
 #include <array>
@@ -46,24 +48,14 @@ std::uint64_t read_u64(std::span<const std::uint8_t> raw, std::size_t& at) {
     return v;
 }
 
-std::string take_str(std::span<const std::uint8_t> raw, std::size_t& at) {
+std::size_t skip_run(std::span<const std::uint8_t> raw, std::size_t& at, const char* label) {
     const auto n = static_cast<std::size_t>(read_u16(raw, at));
     if (at + n > raw.size()) {
-        die("str bounds");
+        die(std::string(label) + " bounds");
     }
-    std::string s(raw.begin() + static_cast<std::ptrdiff_t>(at), raw.begin() + static_cast<std::ptrdiff_t>(at + n));
+    const auto start = at;
     at += n;
-    return s;
-}
-
-std::vector<std::uint8_t> take_vec(std::span<const std::uint8_t> raw, std::size_t& at) {
-    const auto n = static_cast<std::size_t>(read_u16(raw, at));
-    if (at + n > raw.size()) {
-        die("vec bounds");
-    }
-    std::vector<std::uint8_t> v(raw.begin() + static_cast<std::ptrdiff_t>(at), raw.begin() + static_cast<std::ptrdiff_t>(at + n));
-    at += n;
-    return v;
+    return start;
 }
 
 }
@@ -73,18 +65,41 @@ std::uint64_t now_ms() {
     return static_cast<std::uint64_t>(now.time_since_epoch().count());
 }
 
-RelayCore::RelayCore(std::array<std::uint8_t, key_len> key, std::chrono::milliseconds max_skew, std::size_t replay_cap)
-    : rig_(key), max_skew_(max_skew), replay_cap_(replay_cap) {
-    if (replay_cap_ == 0) {
-        die("replay cap cannot be zero");
+std::string_view CtrlView::dev() const {
+    const auto raw = raw_.view();
+    return {reinterpret_cast<const char*>(raw.data() + dev_at_), dev_len_};
+}
+
+std::span<const std::uint8_t> CtrlView::body() const {
+    return raw_.view().subspan(body_at_, body_len_);
+}
+
+Ctrl CtrlView::ctrl() const {
+    return Ctrl{dev(), cmd_, at_ms_, body()};
+}
+
+RelayCore::RelayCore(std::array<std::uint8_t, key_len> key, std::chrono::milliseconds max_skew, std::size_t replay_hint, std::shared_ptr<const Clock> clock, Suite suite)
+    : RelayCore(key, max_skew, std::make_shared<ReplayWheel>(max_skew, replay_hint), std::move(clock), suite) {}
+
+RelayCore::RelayCore(std::array<std::uint8_t, key_len> key, std::chrono::milliseconds max_skew, std::shared_ptr<ReplayStore> replay, std::shared_ptr<const Clock> clock, Suite suite)
+    : rig_(key, suite), clock_(std::move(clock)), max_skew_(max_skew), replay_(std::move(replay)) {
+    if (!replay_) {
+        die("replay store missing");
+    }
+    if (replay_->window() < static_cast<std::uint64_t>(std::max<std::int64_t>(max_skew_.count(), 0))) {
+        die("replay window below skew");
+    }
+    if (!clock_) {
+        die("clock missing");
     }
 }
 
-std::vector<std::uint8_t> RelayCore::aad_for(std::uint64_t seq, std::uint64_t at_ms) const {
-    std::vector<std::uint8_t> out;
-    out.reserve(16);
-    put_u64(out, seq);
-    put_u64(out, at_ms);
+std::array<std::uint8_t, 16> env_aad(std::uint64_t seq, std::uint64_t at_ms) {
+    std::array<std::uint8_t, 16> out{};
+    for (std::size_t i = 0; i < 8; ++i) {
+        out[i] = static_cast<std::uint8_t>((seq >> ((7 - i) * 8)) & 0xFFU);
+        out[8 + i] = static_cast<std::uint8_t>((at_ms >> ((7 - i) * 8)) & 0xFFU);
+    }
     return out;
 }
 
@@ -106,72 +121,112 @@ std::vector<std::uint8_t> RelayCore::pack_ctrl(const Ctrl& ctrl) const {
     return out;
 }
 
-Ctrl RelayCore::unpack_ctrl(std::span<const std::uint8_t> raw) const {
+CtrlView RelayCore::unpack_ctrl(SecureBlob raw) const {
+    const auto bytes = raw.view();
     std::size_t at = 0;
-    Ctrl ctrl{};
-    ctrl.dev = take_str(raw, at);
-    if (at >= raw.size()) {
+    CtrlView view;
+    view.dev_at_ = skip_run(bytes, at, "str");
+    view.dev_len_ = at - view.dev_at_;
+    if (at >= bytes.size()) {
         die("missing cmd");
     }
-    ctrl.cmd = static_cast<Cmd>(raw[at]);
+    view.cmd_ = static_cast<Cmd>(bytes[at]);
     at += 1;
-    ctrl.at_ms = read_u64(raw, at);
-    ctrl.body = take_vec(raw, at);
-    if (at != raw.size()) {
+    view.at_ms_ = read_u64(bytes, at);
+    view.body_at_ = skip_run(bytes, at, "vec");
+    view.body_len_ = at - view.body_at_;
+    if (at != bytes.size()) {
         die("trailing bytes");
     }
-    return ctrl;
-}
-
-bool RelayCore::seen_or_mark(const std::string& k) {
-    auto [it, fresh] = seen_.insert(k);
-    if (!fresh) {
-        return true;
+    if (strict_.load(std::memory_order_acquire) && !body_fits(view.cmd_, bytes.subspan(view.body_at_, view.body_len_))) {
+        die("body schema mismatch");
     }
-    fifo_.push_back(*it);
-    trim();
-    return false;
+    view.raw_ = std::move(raw);
+    return view;
 }
 
-void RelayCore::trim() {
-    while (fifo_.size() > replay_cap_) {
-        const auto& old = fifo_.front();
-        seen_.erase(old);
-        fifo_.pop_front();
-    }
+std::size_t RelayCore::replay_size() const {
+    std::scoped_lock lock(mu_);
+    return replay_->size(clock_->now_ms());
 }
 
 Env RelayCore::seal_ctrl(const Ctrl& ctrl) {
-    std::scoped_lock lock(mu_);
-    ++seq_;
-    const auto aad = aad_for(seq_, ctrl.at_ms);
+    return seal_ctrl(ctrl, seq_.fetch_add(1, std::memory_order_relaxed) + 1);
+}
+
+Env RelayCore::seal_ctrl(const Ctrl& ctrl, std::uint64_t seq) {
+    if (seq == 0) {
+        die("seq invalid");
+    }
     const auto raw = pack_ctrl(ctrl);
     Env env{};
-    env.seq = seq_;
+    env.seq = seq;
     env.at_ms = ctrl.at_ms;
-    env.pkt = rig_.seal(raw, aad);
+    env.pkt = rig_.seal(raw, env_aad(env.seq, env.at_ms));
     return env;
 }
 
-Ctrl RelayCore::open_ctrl(const Env& env) {
-    const auto now = now_ms();
-    const auto low = now >= static_cast<std::uint64_t>(max_skew_.count()) ? now - static_cast<std::uint64_t>(max_skew_.count()) : 0;
-    const auto high = now + static_cast<std::uint64_t>(max_skew_.count());
+CtrlView RelayCore::open_view(const Env& env) {
+    return open_view(env, clock_->now_ms());
+}
+
+void RelayCore::track_clocks(std::shared_ptr<ClockTracker> clocks) {
+    if (clocks && clocks->window() > static_cast<std::uint64_t>(max_skew_.count())) {
+        die("clock window exceeds skew");
+    }
+    clocks_.store(std::move(clocks), std::memory_order_release);
+}
+
+CtrlView RelayCore::unseal(const Env& env, std::uint64_t now, const ClockTracker* clocks) const {
+    const auto skew = static_cast<std::uint64_t>(max_skew_.count()) + (clocks ? clocks->reach() : 0);
+    const auto low = now >= skew ? now - skew : 0;
+    const auto high = now + skew;
     if (env.at_ms < low || env.at_ms > high) {
         die("timestamp skew");
     }
+    return unpack_ctrl(rig_.open(env.pkt, env_aad(env.seq, env.at_ms)));
+}
 
+void RelayCore::mark(const Env& env, std::uint64_t at, std::uint64_t now) {
+    if (replay_->seen_or_mark(ReplayKey::of(env.seq, env.pkt), at, now)) {
+        die("replay blocked");
+    }
+}
+
+CtrlView RelayCore::open_view(const Env& env, std::uint64_t now) {
+    const auto clocks = clocks_.load(std::memory_order_acquire);
+    auto view = unseal(env, now, clocks.get());
+    const auto at = clocks ? clocks->admit(view.dev(), view.cmd(), view.body(), env.at_ms, now) : env.at_ms;
     {
         std::scoped_lock lock(mu_);
-        const std::string key = std::to_string(env.seq) + ":" + hex_of(env.pkt.nonce) + ":" + hex_of(env.pkt.mac);
-        if (seen_or_mark(key)) {
-            die("replay blocked");
-        }
+        mark(env, at, now);
+    }
+    if (clocks) {
+        static_cast<void>(clocks->learn(view.dev(), view.cmd(), view.body(), env.at_ms, now));
+    }
+    return view;
+}
+
+Task<Ctrl> RelayCore::open_async(Env env, std::uint64_t now, Executor& ex) {
+    const auto clocks = clocks_.load(std::memory_order_acquire);
+    const auto view = unseal(env, now, clocks.get());
+    const auto at = clocks ? clocks->admit(view.dev(), view.cmd(), view.body(), env.at_ms, now) : env.at_ms;
+    {
+        const auto lock = co_await mu_.lock(ex);
+        mark(env, at, now);
     }
+    if (clocks) {
+        static_cast<void>(clocks->learn(view.dev(), view.cmd(), view.body(), env.at_ms, now));
+    }
+    co_return view.ctrl();
+}
+
+Ctrl RelayCore::open_ctrl(const Env& env) {
+    return open_view(env).ctrl();
+}
 
-    const auto aad = aad_for(env.seq, env.at_ms);
-    const auto plain = rig_.open(env.pkt, aad);
-    return unpack_ctrl(plain.view());
+Ctrl RelayCore::open_ctrl(const Env& env, std::uint64_t now) {
+    return open_view(env, now).ctrl();
 }
 
 }
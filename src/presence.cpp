@@ -0,0 +1,219 @@
+#include "syncstream/presence.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+
+namespace syncstream {
+namespace {
+
+[[noreturn]] void die(const std::string& msg) {
+    throw std::runtime_error(msg);
+}
+
+}
+
+PresenceTable::PresenceTable(std::size_t capacity, std::chrono::milliseconds timeout, std::chrono::milliseconds tick)
+    : timeout_(0), tick_(0), slots_(capacity), names_(capacity), index_(std::bit_ceil(std::max<std::size_t>(capacity, 1) * 2)), nodes_(capacity) {
+    if (capacity == 0 || capacity >= none) {
+        die("presence capacity invalid");
+    }
+    if (timeout.count() <= 0 || tick.count() <= 0 || tick > timeout) {
+        die("presence timing invalid");
+    }
+    timeout_ = static_cast<std::uint64_t>(timeout.count());
+    tick_ = static_cast<std::uint64_t>(tick.count());
+    for (auto& slot : index_) {
+        slot.store(none, std::memory_order_relaxed);
+    }
+    heads_.fill(none);
+}
+
+void PresenceTable::subscribe(PresenceFn fn) {
+    std::scoped_lock lock(notify_mu_);
+    subs_.push_back(std::move(fn));
+}
+
+std::size_t PresenceTable::probe_of(std::string_view dev) const {
+    return std::hash<std::string_view>{}(dev) & (index_.size() - 1);
+}
+
+std::optional<std::uint32_t> PresenceTable::index_of(std::string_view dev) const {
+    for (auto at = probe_of(dev);; at = (at + 1) & (index_.size() - 1)) {
+        const auto idx = index_[at].load(std::memory_order_acquire);
+        if (idx == none) {
+            return std::nullopt;
+        }
+        if (names_[idx].str() == dev) {
+            return idx;
+        }
+    }
+}
+
+std::optional<std::uint32_t> PresenceTable::enroll(std::string_view dev) {
+    if (const auto idx = index_of(dev)) {
+        return idx;
+    }
+    std::scoped_lock lock(enroll_mu_);
+    auto at = probe_of(dev);
+    for (;; at = (at + 1) & (index_.size() - 1)) {
+        const auto idx = index_[at].load(std::memory_order_relaxed);
+        if (idx == none) {
+            break;
+        }
+        if (names_[idx].str() == dev) {
+            return idx;
+        }
+    }
+    const auto n = count_.load(std::memory_order_relaxed);
+    if (n == slots_.size()) {
+        return std::nullopt;
+    }
+    const auto idx = static_cast<std::uint32_t>(n);
+    names_[idx] = dev;
+    index_[at].store(idx, std::memory_order_release);
+    count_.store(n + 1, std::memory_order_release);
+    return idx;
+}
+
+bool PresenceTable::seen(std::string_view dev, std::uint64_t at_ms) {
+    const auto idx = enroll(dev);
+    if (!idx) {
+        return false;
+    }
+    auto& slot = slots_[*idx];
+    auto last = slot.seen.load(std::memory_order_relaxed);
+    while (last < at_ms && !slot.seen.compare_exchange_weak(last, at_ms, std::memory_order_release, std::memory_order_relaxed)) {
+    }
+    const auto was = slot.state.exchange(static_cast<std::uint8_t>(Presence::online), std::memory_order_acq_rel);
+    if (was == static_cast<std::uint8_t>(Presence::online)) {
+        return true;
+    }
+    online_.fetch_add(1, std::memory_order_relaxed);
+    std::unique_lock wheel(wheel_mu_);
+    schedule(*idx, std::max(last, at_ms) + timeout_);
+    std::scoped_lock order(notify_mu_);
+    wheel.unlock();
+    notify({Change{*idx, Presence::online, at_ms}});
+    return true;
+}
+
+void PresenceTable::schedule(std::uint32_t idx, std::uint64_t due_ms) {
+    auto& node = nodes_[idx];
+    if (node.bucket != none) {
+        return;
+    }
+    if (!started_) {
+        cur_ = (due_ms - timeout_) / tick_;
+        started_ = true;
+    }
+    node.due = (due_ms + tick_ - 1) / tick_;
+    place(idx, cur_ + 1);
+}
+
+void PresenceTable::place(std::uint32_t idx, std::uint64_t floor) {
+    auto& node = nodes_[idx];
+    auto due = std::max(node.due, floor);
+    const auto delta = due - cur_;
+    std::size_t level = 0;
+    while (level + 1 < wheel_levels && delta >= (std::uint64_t{1} << (wheel_bits * (level + 1)))) {
+        ++level;
+    }
+    if (delta >= (std::uint64_t{1} << (wheel_bits * wheel_levels))) {
+        due = cur_ + (std::uint64_t{1} << (wheel_bits * wheel_levels)) - 1;
+    }
+    const auto bucket = static_cast<std::uint32_t>(level * wheel_size + ((due >> (wheel_bits * level)) & (wheel_size - 1)));
+    node.bucket = bucket;
+    node.next = heads_[bucket];
+    heads_[bucket] = idx;
+}
+
+void PresenceTable::cascade(std::size_t level) {
+    const auto bucket = level * wheel_size + ((cur_ >> (wheel_bits * level)) & (wheel_size - 1));
+    auto idx = heads_[bucket];
+    heads_[bucket] = none;
+    while (idx != none) {
+        const auto next = nodes_[idx].next;
+        nodes_[idx].bucket = none;
+        place(idx, cur_);
+        idx = next;
+    }
+}
+
+std::size_t PresenceTable::advance(std::uint64_t now) {
+    std::vector<Change> changes;
+    std::unique_lock wheel(wheel_mu_);
+    if (!started_) {
+        return 0;
+    }
+    const auto target = now / tick_;
+    if (online_.load(std::memory_order_relaxed) == 0) {
+        cur_ = std::max(cur_, target);
+    }
+    while (cur_ < target) {
+        ++cur_;
+        for (std::size_t level = wheel_levels - 1; level > 0; --level) {
+            if ((cur_ & ((std::uint64_t{1} << (wheel_bits * level)) - 1)) == 0) {
+                cascade(level);
+            }
+        }
+        const auto bucket = static_cast<std::size_t>(cur_ & (wheel_size - 1));
+        auto idx = heads_[bucket];
+        heads_[bucket] = none;
+        while (idx != none) {
+            auto& node = nodes_[idx];
+            const auto next = node.next;
+            node.bucket = none;
+            auto& slot = slots_[idx];
+            const auto last = slot.seen.load(std::memory_order_acquire);
+            const auto due = last + timeout_;
+            auto expect = static_cast<std::uint8_t>(Presence::online);
+            if (node.due > cur_ || due > now) {
+                node.due = std::max(node.due, (due + tick_ - 1) / tick_);
+                place(idx, cur_ + 1);
+            } else if (slot.state.compare_exchange_strong(expect, static_cast<std::uint8_t>(Presence::offline), std::memory_order_acq_rel)) {
+                expect = static_cast<std::uint8_t>(Presence::offline);
+                const auto fresh = slot.seen.load(std::memory_order_acquire);
+                if (fresh != last && slot.state.compare_exchange_strong(expect, static_cast<std::uint8_t>(Presence::online), std::memory_order_acq_rel)) {
+                    node.due = (fresh + timeout_ + tick_ - 1) / tick_;
+                    place(idx, cur_ + 1);
+                } else {
+                    online_.fetch_sub(1, std::memory_order_relaxed);
+                    changes.push_back(Change{idx, Presence::offline, due});
+                }
+            }
+            idx = next;
+        }
+    }
+    std::scoped_lock order(notify_mu_);
+    wheel.unlock();
+    notify(changes);
+    return changes.size();
+}
+
+void PresenceTable::notify(const std::vector<Change>& changes) const {
+    for (const auto& c : changes) {
+        for (const auto& fn : subs_) {
+            fn(names_[c.idx].str(), c.state, c.at_ms);
+        }
+    }
+}
+
+Presence PresenceTable::state(std::string_view dev) const {
+    const auto idx = index_of(dev);
+    return idx ? state_at(*idx) : Presence::unknown;
+}
+
+std::optional<std::uint64_t> PresenceTable::last_seen(std::string_view dev) const {
+    const auto idx = index_of(dev);
+    if (!idx) {
+        return std::nullopt;
+    }
+    const auto at = slots_[*idx].seen.load(std::memory_order_acquire);
+    if (at == 0) {
+        return std::nullopt;
+    }
+    return at;
+}
+
+}
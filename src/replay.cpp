@@ -0,0 +1,141 @@
+#include "syncstream/replay.hpp"
+
+#include <openssl/rand.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+namespace syncstream {
+namespace {
+
+[[noreturn]] void die(const std::string& msg) {
+    throw std::runtime_error(msg);
+}
+
+constexpr std::uint64_t wheel_parts = 4;
+
+std::uint64_t mix(std::uint64_t v) {
+    v ^= v >> 30;
+    v *= 0xBF58476D1CE4E5B9ULL;
+    v ^= v >> 27;
+    v *= 0x94D049BB133111EBULL;
+    v ^= v >> 31;
+    return v;
+}
+
+std::uint64_t load64(const std::uint8_t* p) {
+    std::uint64_t v = 0;
+    for (int i = 0; i < 8; ++i) {
+        v = (v << 8) | p[i];
+    }
+    return v;
+}
+
+}
+
+ReplayKey ReplayKey::of(std::uint64_t seq, const Packet& pkt) {
+    ReplayKey key;
+    for (std::size_t i = 0; i < 8; ++i) {
+        key.raw[i] = static_cast<std::uint8_t>((seq >> ((7 - i) * 8)) & 0xFFU);
+    }
+    std::copy(pkt.nonce.begin(), pkt.nonce.end(), key.raw.begin() + 8);
+    std::copy(pkt.mac.begin(), pkt.mac.end(), key.raw.begin() + 8 + nonce_len);
+    return key;
+}
+
+std::uint64_t replay_hash(const ReplayKey& key, std::uint64_t seed) {
+    const auto* p = key.raw.data();
+    const std::uint64_t a = mix(load64(p + 8 + nonce_len) ^ seed);
+    const std::uint64_t b = mix(load64(p + 8 + nonce_len + 8) + load64(p) + seed);
+    return a ^ (b >> 1);
+}
+
+std::uint64_t replay_span(std::chrono::milliseconds window) {
+    const auto w = static_cast<std::uint64_t>(std::max<std::int64_t>(window.count(), 0));
+    return std::max<std::uint64_t>(1, w / wheel_parts);
+}
+
+ReplayWheel::ReplayWheel(std::chrono::milliseconds window, std::size_t hint)
+    : window_(static_cast<std::uint64_t>(std::max<std::int64_t>(window.count(), 0))), span_(replay_span(window)), fill_(0) {
+    if (RAND_bytes(reinterpret_cast<unsigned char*>(&seed_), sizeof(seed_)) != 1) {
+        die("replay seed failed");
+    }
+    const auto count = static_cast<std::size_t>(2 * window_ / span_ + 3);
+    fill_ = hint / count;
+    ring_.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        ring_.push_back(Bucket{0, false, std::unordered_set<ReplayKey, KeyHash>(0, KeyHash{seed_})});
+    }
+}
+
+bool ReplayWheel::expired(std::uint64_t epoch, std::uint64_t now) const {
+    return (epoch + 1) * span_ + window_ <= now;
+}
+
+std::size_t ReplayWheel::drop(Bucket& bucket) {
+    const std::size_t n = bucket.keys.size();
+    fill_ = n;
+    std::unordered_set<ReplayKey, KeyHash>(0, KeyHash{seed_}).swap(bucket.keys);
+    bucket.used = false;
+    live_ -= n;
+    return n;
+}
+
+std::size_t ReplayWheel::sweep(std::uint64_t now) {
+    swept_ = std::max(swept_, now / span_);
+    std::size_t gone = 0;
+    for (auto& bucket : ring_) {
+        if (bucket.used && expired(bucket.epoch, now)) {
+            gone += drop(bucket);
+        }
+    }
+    return gone;
+}
+
+std::size_t ReplayWheel::size(std::uint64_t now) const {
+    std::size_t n = live_;
+    for (const auto& bucket : ring_) {
+        if (bucket.used && expired(bucket.epoch, now)) {
+            n -= bucket.keys.size();
+        }
+    }
+    return n;
+}
+
+bool ReplayWheel::holds(const ReplayKey& key, std::uint64_t epoch) const {
+    const auto& bucket = ring_[static_cast<std::size_t>(epoch % ring_.size())];
+    return bucket.used && bucket.epoch == epoch && bucket.keys.find(key) != bucket.keys.end();
+}
+
+bool ReplayWheel::seen_or_mark(const ReplayKey& key, std::uint64_t at_ms, std::uint64_t now) {
+    if (now / span_ > swept_) {
+        static_cast<void>(sweep(now));
+    }
+    const std::uint64_t epoch = at_ms / span_;
+    if (expired(epoch, now)) {
+        die("replay window passed");
+    }
+    if ((epoch > 0 && holds(key, epoch - 1)) || holds(key, epoch + 1)) {
+        return true;
+    }
+    auto& bucket = ring_[static_cast<std::size_t>(epoch % ring_.size())];
+    if (bucket.used && bucket.epoch != epoch) {
+        if (bucket.epoch < epoch && !expired(bucket.epoch, now)) {
+            die("replay wheel overrun");
+        }
+        static_cast<void>(drop(bucket));
+    }
+    if (!bucket.used) {
+        bucket.used = true;
+        bucket.epoch = epoch;
+        bucket.keys.reserve(fill_);
+    }
+    const bool fresh = bucket.keys.insert(key).second;
+    if (fresh) {
+        ++live_;
+    }
+    return !fresh;
+}
+
+}
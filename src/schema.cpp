@@ -0,0 +1,44 @@
+#include "syncstream/schema.hpp"
+#include "syncstream/ack.hpp"
+#include "syncstream/beats.hpp"
+#include "syncstream/clock_sync.hpp"
+#include "syncstream/sync_state.hpp"
+
+namespace syncstream {
+namespace {
+
+template <typename T>
+bool fits_body(std::span<const std::uint8_t> body) {
+    if constexpr (requires { BodyLayout<T>::fits(body); }) {
+        return BodyLayout<T>::fits(body);
+    } else {
+        T out{};
+        return try_decode_body(body, out);
+    }
+}
+
+template <Cmd C>
+bool fits_one(Cmd cmd, std::span<const std::uint8_t> body) {
+    if (cmd != C) {
+        return true;
+    }
+    if constexpr (requires { CmdBody<C>::empty_ok; }) {
+        if (body.empty()) {
+            return true;
+        }
+    }
+    return fits_body<body_t<C>>(body);
+}
+
+template <Cmd... Cs>
+bool fits_all(CmdList<Cs...>, Cmd cmd, std::span<const std::uint8_t> body) {
+    return (fits_one<Cs>(cmd, body) && ...);
+}
+
+}
+
+bool body_fits(Cmd cmd, std::span<const std::uint8_t> body) {
+    return fits_all(TypedCmds{}, cmd, body);
+}
+
+}
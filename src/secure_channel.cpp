@@ -1,12 +1,22 @@
 #include "syncstream/secure_channel.hpp"
+#include "syncstream/codec.hpp"
+#include "syncstream/secure_pool.hpp"
 
 #include <limits>
 #include <openssl/crypto.h>
 #include <openssl/evp.h>
 #include <openssl/rand.h>
 
+#if defined(__aarch64__) && defined(__linux__)
+#include <asm/hwcap.h>
+#include <sys/auxv.h>
+#endif
+
+#include <algorithm>
+#include <chrono>
 #include <memory>
 #include <stdexcept>
+#include <utility>
 
 namespace syncstream {
 namespace {
@@ -29,62 +39,101 @@ void chk(int code, const char* msg) {
     }
 }
 
-void chk_open_ssl_size(std::size_t size, const char* label) {
-    if (size > static_cast<std::size_t>(std::numeric_limits<int>::max())) {
-        toss(std::string(label) + " too large");
+const EVP_CIPHER* evp_of(Suite suite) {
+    switch (suite) {
+    case Suite::aes_gcm:
+        return EVP_aes_256_gcm();
+    case Suite::chacha_poly:
+        return EVP_chacha20_poly1305();
     }
+    toss("cipher suite unknown");
 }
 
-std::uint8_t nib(char c) {
-    if (c >= '0' && c <= '9') {
-        return static_cast<std::uint8_t>(c - '0');
-    }
-    if (c >= 'a' && c <= 'f') {
-        return static_cast<std::uint8_t>(10 + c - 'a');
+double probe_suite(Suite suite) {
+    const auto key = mint_key();
+    const CipherRig rig(key, suite);
+    const std::vector<std::uint8_t> plain(64, 0x5A);
+    const std::array<std::uint8_t, 16> aad{};
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 4096; ++i) {
+        static_cast<void>(rig.seal(plain, aad));
     }
-    if (c >= 'A' && c <= 'F') {
-        return static_cast<std::uint8_t>(10 + c - 'A');
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void chk_open_ssl_size(std::size_t size, const char* label) {
+    if (size > static_cast<std::size_t>(std::numeric_limits<int>::max())) {
+        toss(std::string(label) + " too large");
     }
-    toss("invalid hex character");
 }
 
 }
 
-SecureBlob::SecureBlob(std::vector<std::uint8_t> data) : data_(std::move(data)) {}
+SecureBlob::SecureBlob(std::size_t len) : ptr_(SecurePool::global().grab(len)), len_(len) {}
+
+SecureBlob::SecureBlob(std::vector<std::uint8_t> data) : SecureBlob(data.size()) {
+    std::copy(data.begin(), data.end(), ptr_);
+    zero(data);
+}
 
-SecureBlob::SecureBlob(SecureBlob&& other) noexcept : data_(std::move(other.data_)) {}
+SecureBlob::SecureBlob(SecureBlob&& other) noexcept : ptr_(std::exchange(other.ptr_, nullptr)), len_(std::exchange(other.len_, 0)) {}
 
 SecureBlob& SecureBlob::operator=(SecureBlob&& other) noexcept {
     if (this != &other) {
-        zero(data_);
-        data_ = std::move(other.data_);
+        release();
+        ptr_ = std::exchange(other.ptr_, nullptr);
+        len_ = std::exchange(other.len_, 0);
     }
     return *this;
 }
 
 SecureBlob::~SecureBlob() {
-    zero(data_);
+    release();
+}
+
+void SecureBlob::release() {
+    SecurePool::global().give(ptr_, len_);
+    ptr_ = nullptr;
+    len_ = 0;
+}
+
+SecureBlob SecureBlob::copy_of(std::span<const std::uint8_t> data) {
+    SecureBlob out(data.size());
+    std::copy(data.begin(), data.end(), out.ptr_);
+    return out;
 }
 
 std::span<const std::uint8_t> SecureBlob::view() const {
-    return data_;
+    return {ptr_, len_};
 }
 
-std::vector<std::uint8_t> SecureBlob::take() {
-    return std::move(data_);
+std::span<std::uint8_t> SecureBlob::bytes() {
+    return {ptr_, len_};
 }
 
-CipherRig::CipherRig(std::array<std::uint8_t, key_len> key) : key_(key) {}
+std::size_t SecureBlob::size() const {
+    return len_;
+}
+
+std::vector<std::uint8_t> SecureBlob::take() {
+    std::vector<std::uint8_t> out(ptr_, ptr_ + len_);
+    release();
+    return out;
+}
 
-CipherRig::~CipherRig() {
-    zero(key_);
+CipherRig::CipherRig(std::array<std::uint8_t, key_len> key, Suite suite) : key_(SecureBlob::copy_of(key)), suite_(suite) {
+    zero(key);
+    static_cast<void>(evp_of(suite_));
 }
 
+CipherRig::~CipherRig() = default;
+
 Packet CipherRig::seal(std::span<const std::uint8_t> plain, std::span<const std::uint8_t> aad) const {
     chk_open_ssl_size(plain.size(), "plaintext");
     chk_open_ssl_size(aad.size(), "aad");
 
     Packet pack;
+    pack.suite = suite_;
     chk(RAND_bytes(pack.nonce.data(), static_cast<int>(pack.nonce.size())), "nonce generation failed");
     pack.body.resize(plain.size());
 
@@ -93,9 +142,9 @@ Packet CipherRig::seal(std::span<const std::uint8_t> plain, std::span<const std:
         toss("cipher context allocation failed");
     }
 
-    chk(EVP_EncryptInit_ex(ctx.get(), EVP_aes_256_gcm(), nullptr, nullptr, nullptr), "encrypt init failed");
-    chk(EVP_CIPHER_CTX_ctrl(ctx.get(), EVP_CTRL_GCM_SET_IVLEN, static_cast<int>(pack.nonce.size()), nullptr), "iv length setup failed");
-    chk(EVP_EncryptInit_ex(ctx.get(), nullptr, nullptr, key_.data(), pack.nonce.data()), "key setup failed");
+    chk(EVP_EncryptInit_ex(ctx.get(), evp_of(suite_), nullptr, nullptr, nullptr), "encrypt init failed");
+    chk(EVP_CIPHER_CTX_ctrl(ctx.get(), EVP_CTRL_AEAD_SET_IVLEN, static_cast<int>(pack.nonce.size()), nullptr), "iv length setup failed");
+    chk(EVP_EncryptInit_ex(ctx.get(), nullptr, nullptr, key_.view().data(), pack.nonce.data()), "key setup failed");
 
     int out_len = 0;
     if (!aad.empty()) {
@@ -111,47 +160,49 @@ Packet CipherRig::seal(std::span<const std::uint8_t> plain, std::span<const std:
         toss("unexpected ciphertext size");
     }
 
-    chk(EVP_CIPHER_CTX_ctrl(ctx.get(), EVP_CTRL_GCM_GET_TAG, static_cast<int>(pack.mac.size()), pack.mac.data()), "tag read failed");
+    chk(EVP_CIPHER_CTX_ctrl(ctx.get(), EVP_CTRL_AEAD_GET_TAG, static_cast<int>(pack.mac.size()), pack.mac.data()), "tag read failed");
     return pack;
 }
 
 SecureBlob CipherRig::open(const Packet& pack, std::span<const std::uint8_t> aad) const {
     chk_open_ssl_size(pack.body.size(), "ciphertext");
     chk_open_ssl_size(aad.size(), "aad");
+    if (pack.suite != suite_) {
+        toss("cipher suite mismatch");
+    }
 
-    std::vector<std::uint8_t> plain(pack.body.size());
+    SecureBlob plain(pack.body.size());
+    const auto out = plain.bytes();
     EvpPtr ctx(EVP_CIPHER_CTX_new(), EVP_CIPHER_CTX_free);
     if (!ctx) {
         toss("cipher context allocation failed");
     }
 
-    chk(EVP_DecryptInit_ex(ctx.get(), EVP_aes_256_gcm(), nullptr, nullptr, nullptr), "decrypt init failed");
-    chk(EVP_CIPHER_CTX_ctrl(ctx.get(), EVP_CTRL_GCM_SET_IVLEN, static_cast<int>(pack.nonce.size()), nullptr), "iv length setup failed");
-    chk(EVP_DecryptInit_ex(ctx.get(), nullptr, nullptr, key_.data(), pack.nonce.data()), "key setup failed");
+    chk(EVP_DecryptInit_ex(ctx.get(), evp_of(suite_), nullptr, nullptr, nullptr), "decrypt init failed");
+    chk(EVP_CIPHER_CTX_ctrl(ctx.get(), EVP_CTRL_AEAD_SET_IVLEN, static_cast<int>(pack.nonce.size()), nullptr), "iv length setup failed");
+    chk(EVP_DecryptInit_ex(ctx.get(), nullptr, nullptr, key_.view().data(), pack.nonce.data()), "key setup failed");
 
     int out_len = 0;
     if (!aad.empty()) {
         chk(EVP_DecryptUpdate(ctx.get(), nullptr, &out_len, aad.data(), static_cast<int>(aad.size())), "aad decrypt failed");
     }
 
-    chk(EVP_DecryptUpdate(ctx.get(), plain.data(), &out_len, pack.body.data(), static_cast<int>(pack.body.size())), "payload decrypt failed");
+    chk(EVP_DecryptUpdate(ctx.get(), out.data(), &out_len, pack.body.data(), static_cast<int>(pack.body.size())), "payload decrypt failed");
     auto tag = pack.mac;
-    chk(EVP_CIPHER_CTX_ctrl(ctx.get(), EVP_CTRL_GCM_SET_TAG, static_cast<int>(tag.size()), tag.data()), "tag setup failed");
+    chk(EVP_CIPHER_CTX_ctrl(ctx.get(), EVP_CTRL_AEAD_SET_TAG, static_cast<int>(tag.size()), tag.data()), "tag setup failed");
 
     int fin_len = 0;
-    const int ok = EVP_DecryptFinal_ex(ctx.get(), plain.data() + out_len, &fin_len);
+    const int ok = EVP_DecryptFinal_ex(ctx.get(), out.data() + out_len, &fin_len);
     if (ok != 1) {
-        zero(plain);
         toss("authentication failed");
     }
 
     const std::size_t produced = static_cast<std::size_t>(out_len + fin_len);
     if (produced != plain.size()) {
-        zero(plain);
         toss("unexpected plaintext size");
     }
 
-    return SecureBlob(std::move(plain));
+    return plain;
 }
 
 std::array<std::uint8_t, key_len> mint_key() {
@@ -160,28 +211,47 @@ std::array<std::uint8_t, key_len> mint_key() {
     return key;
 }
 
-std::string hex_of(std::span<const std::uint8_t> data) {
-    static constexpr char lut[] = "0123456789abcdef";
-    std::string out;
-    out.resize(data.size() * 2);
-    for (std::size_t i = 0; i < data.size(); ++i) {
-        out[i * 2] = lut[data[i] >> 4];
-        out[i * 2 + 1] = lut[data[i] & 0x0F];
+bool has_aes_hw() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __builtin_cpu_supports("aes") != 0;
+#elif defined(__aarch64__) && defined(__linux__)
+    return (getauxval(AT_HWCAP) & HWCAP_AES) != 0;
+#elif defined(__aarch64__) && defined(__APPLE__)
+    return true;
+#else
+    return false;
+#endif
+}
+
+Suite pick_suite() {
+    static const Suite picked = [] {
+        if (!has_aes_hw()) {
+            return Suite::chacha_poly;
+        }
+        return probe_suite(Suite::chacha_poly) < probe_suite(Suite::aes_gcm) ? Suite::chacha_poly : Suite::aes_gcm;
+    }();
+    return picked;
+}
+
+const char* suite_name(Suite suite) {
+    switch (suite) {
+    case Suite::aes_gcm:
+        return "aes-256-gcm";
+    case Suite::chacha_poly:
+        return "chacha20-poly1305";
     }
+    return "unknown";
+}
+
+std::string hex_of(std::span<const std::uint8_t> data) {
+    std::string out(hex_len(data.size()), '\0');
+    hex_encode(data, out);
     return out;
 }
 
 std::vector<std::uint8_t> from_hex(const std::string& text) {
-    if ((text.size() % 2U) != 0U) {
-        toss("hex input must have even length");
-    }
-    std::vector<std::uint8_t> out;
-    out.reserve(text.size() / 2U);
-    for (std::size_t i = 0; i < text.size(); i += 2) {
-        const std::uint8_t hi = nib(text[i]);
-        const std::uint8_t lo = nib(text[i + 1]);
-        out.push_back(static_cast<std::uint8_t>((hi << 4) | lo));
-    }
+    std::vector<std::uint8_t> out(text.size() / 2U);
+    hex_decode(text, out);
     return out;
 }
 
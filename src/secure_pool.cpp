@@ -0,0 +1,204 @@
+#include "syncstream/secure_pool.hpp"
+
+#include <openssl/crypto.h>
+
+#include <algorithm>
+#include <new>
+#include <stdexcept>
+#include <string>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define SYNCSTREAM_POSIX_POOL 1
+#include <sys/mman.h>
+#include <unistd.h>
+#elif defined(_WIN32)
+#define SYNCSTREAM_WIN_POOL 1
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#endif
+
+namespace syncstream {
+namespace {
+
+constexpr std::size_t slab_len = 64 * 1024;
+
+[[noreturn]] void die(const std::string& msg) {
+    throw std::runtime_error(msg);
+}
+
+std::size_t round_up(std::size_t n, std::size_t unit) {
+    return (n + unit - 1) / unit * unit;
+}
+
+}
+
+SecurePool::SecurePool() {
+#if defined(SYNCSTREAM_POSIX_POOL)
+    const long page = sysconf(_SC_PAGESIZE);
+    page_ = page > 0 ? static_cast<std::size_t>(page) : 4096;
+#elif defined(SYNCSTREAM_WIN_POOL)
+    SYSTEM_INFO info{};
+    GetSystemInfo(&info);
+    page_ = info.dwPageSize > 0 ? static_cast<std::size_t>(info.dwPageSize) : 4096;
+#else
+    page_ = 4096;
+#endif
+}
+
+SecurePool::~SecurePool() {
+    for (auto& tier : tiers_) {
+        std::scoped_lock lock(tier.mu);
+        for (const auto& slab : tier.slabs) {
+            unmap_guarded(slab);
+        }
+    }
+    std::scoped_lock lock(large_mu_);
+    for (const auto& [_, span] : large_) {
+        unmap_guarded(span);
+    }
+}
+
+SecurePool& SecurePool::global() {
+    static auto* pool = new SecurePool();
+    return *pool;
+}
+
+std::size_t SecurePool::tier_of(std::size_t n) {
+    std::size_t idx = 0;
+    std::size_t cls = min_class;
+    while (cls < n) {
+        cls <<= 1;
+        ++idx;
+    }
+    return idx;
+}
+
+SecurePool::Span SecurePool::map_guarded(std::size_t n) {
+    const std::size_t len = round_up(n, page_);
+#if defined(SYNCSTREAM_POSIX_POOL)
+    void* raw = mmap(nullptr, len + 2 * page_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED) {
+        die("secure pool map failed");
+    }
+    auto* base = static_cast<std::uint8_t*>(raw);
+    if (mprotect(base, page_, PROT_NONE) != 0 || mprotect(base + page_ + len, page_, PROT_NONE) != 0) {
+        munmap(raw, len + 2 * page_);
+        die("secure pool guard failed");
+    }
+    if (mlock(base + page_, len) != 0) {
+        locked_.store(false, std::memory_order_relaxed);
+    }
+#if defined(MADV_DONTDUMP)
+    static_cast<void>(madvise(base + page_, len, MADV_DONTDUMP));
+#endif
+    return Span{base + page_, len};
+#elif defined(SYNCSTREAM_WIN_POOL)
+    void* raw = VirtualAlloc(nullptr, len + 2 * page_, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    if (raw == nullptr) {
+        die("secure pool map failed");
+    }
+    auto* base = static_cast<std::uint8_t*>(raw);
+    DWORD old = 0;
+    if (!VirtualProtect(base, page_, PAGE_NOACCESS, &old) || !VirtualProtect(base + page_ + len, page_, PAGE_NOACCESS, &old)) {
+        VirtualFree(raw, 0, MEM_RELEASE);
+        die("secure pool guard failed");
+    }
+    if (!VirtualLock(base + page_, len)) {
+        locked_.store(false, std::memory_order_relaxed);
+    }
+    return Span{base + page_, len};
+#else
+    auto* base = static_cast<std::uint8_t*>(::operator new(len, std::align_val_t{64}));
+    std::fill_n(base, len, std::uint8_t{0});
+    locked_.store(false, std::memory_order_relaxed);
+    return Span{base, len};
+#endif
+}
+
+void SecurePool::unmap_guarded(Span span) {
+    OPENSSL_cleanse(span.base, span.len);
+#if defined(SYNCSTREAM_POSIX_POOL)
+    static_cast<void>(munlock(span.base, span.len));
+    static_cast<void>(munmap(span.base - page_, span.len + 2 * page_));
+#elif defined(SYNCSTREAM_WIN_POOL)
+    static_cast<void>(VirtualUnlock(span.base, span.len));
+    static_cast<void>(VirtualFree(span.base - page_, 0, MEM_RELEASE));
+#else
+    ::operator delete(span.base, std::align_val_t{64});
+#endif
+}
+
+void SecurePool::grow(Tier& tier, std::size_t block) {
+    const auto slab = map_guarded(std::max(slab_len, block));
+    tier.slabs.push_back(slab);
+    const std::size_t count = slab.len / block;
+    tier.free.reserve(tier.free.size() + count);
+    for (std::size_t i = count; i > 0; --i) {
+        tier.free.push_back(slab.base + (i - 1) * block);
+    }
+}
+
+std::uint8_t* SecurePool::grab(std::size_t n) {
+    if (n == 0) {
+        return nullptr;
+    }
+    if (n > max_class) {
+        const auto span = map_guarded(n);
+        std::scoped_lock lock(large_mu_);
+        large_.emplace(span.base, span);
+        return span.base;
+    }
+    const std::size_t idx = tier_of(n);
+    auto& tier = tiers_[idx];
+    std::scoped_lock lock(tier.mu);
+    if (tier.free.empty()) {
+        grow(tier, min_class << idx);
+    }
+    auto* p = tier.free.back();
+    tier.free.pop_back();
+    ++tier.in_use;
+    return p;
+}
+
+void SecurePool::give(std::uint8_t* p, std::size_t n) {
+    if (p == nullptr) {
+        return;
+    }
+    if (n > max_class) {
+        Span span{};
+        {
+            std::scoped_lock lock(large_mu_);
+            const auto it = large_.find(p);
+            if (it == large_.end()) {
+                die("secure pool block unknown");
+            }
+            span = it->second;
+            large_.erase(it);
+        }
+        unmap_guarded(span);
+        return;
+    }
+    const std::size_t idx = tier_of(n);
+    OPENSSL_cleanse(p, min_class << idx);
+    auto& tier = tiers_[idx];
+    std::scoped_lock lock(tier.mu);
+    tier.free.push_back(p);
+    --tier.in_use;
+}
+
+SecurePool::Stats SecurePool::stats() const {
+    Stats out{0, 0, 0, locked_.load(std::memory_order_relaxed)};
+    for (const auto& tier : tiers_) {
+        std::scoped_lock lock(tier.mu);
+        out.slabs += tier.slabs.size();
+        out.in_use += tier.in_use;
+    }
+    std::scoped_lock lock(large_mu_);
+    out.large = large_.size();
+    out.in_use += large_.size();
+    return out;
+}
+
+}
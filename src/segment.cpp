@@ -0,0 +1,266 @@
+#include "syncstream/segment.hpp"
+
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
+
+#include <algorithm>
+#include <exception>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+
+namespace syncstream {
+namespace {
+
+constexpr std::string_view seal_label = "syncstream-segment";
+constexpr std::uint8_t leaf_tag = 0x00;
+constexpr std::uint8_t node_tag = 0x01;
+constexpr std::size_t min_per_worker = 8;
+
+[[noreturn]] void die(const std::string& msg) {
+    throw std::runtime_error(msg);
+}
+
+void chk(int code, const char* msg) {
+    if (code != 1) {
+        die(msg);
+    }
+}
+
+class Hasher {
+public:
+    Hasher() : ctx_(EVP_MD_CTX_new()) {
+        if (!ctx_) {
+            die("digest context failed");
+        }
+    }
+    ~Hasher() { EVP_MD_CTX_free(ctx_); }
+    Hasher(const Hasher&) = delete;
+    Hasher& operator=(const Hasher&) = delete;
+
+    Digest leaf(std::span<const std::uint8_t> chunk) {
+        begin(leaf_tag);
+        chk(EVP_DigestUpdate(ctx_, chunk.data(), chunk.size()), "digest update failed");
+        return end();
+    }
+
+    Digest node(const Digest& left, const Digest& right) {
+        begin(node_tag);
+        chk(EVP_DigestUpdate(ctx_, left.data(), left.size()), "digest update failed");
+        chk(EVP_DigestUpdate(ctx_, right.data(), right.size()), "digest update failed");
+        return end();
+    }
+
+private:
+    void begin(std::uint8_t tag) {
+        chk(EVP_DigestInit_ex(ctx_, EVP_sha256(), nullptr), "digest init failed");
+        chk(EVP_DigestUpdate(ctx_, &tag, 1), "digest update failed");
+    }
+
+    Digest end() {
+        Digest out{};
+        unsigned int n = 0;
+        chk(EVP_DigestFinal_ex(ctx_, out.data(), &n), "digest final failed");
+        return out;
+    }
+
+    EVP_MD_CTX* ctx_;
+};
+
+std::vector<Digest> hash_leaves(ChunkList chunks, std::size_t threads) {
+    std::vector<Digest> out(chunks.size());
+    if (threads == 0) {
+        threads = std::max<std::size_t>(1, std::thread::hardware_concurrency());
+    }
+    threads = std::clamp<std::size_t>(chunks.size() / min_per_worker, 1, threads);
+
+    std::vector<std::exception_ptr> errs(threads);
+    const auto run = [&](std::size_t id) {
+        try {
+            Hasher h;
+            for (std::size_t i = id; i < chunks.size(); i += threads) {
+                out[i] = h.leaf(chunks[i]);
+            }
+        } catch (...) {
+            errs[id] = std::current_exception();
+        }
+    };
+
+    {
+        std::vector<std::jthread> pool;
+        pool.reserve(threads - 1);
+        for (std::size_t id = 1; id < threads; ++id) {
+            pool.emplace_back(run, id);
+        }
+        run(0);
+    }
+    for (const auto& err : errs) {
+        if (err) {
+            std::rethrow_exception(err);
+        }
+    }
+    return out;
+}
+
+std::vector<std::uint8_t> seal_aad(std::uint32_t ver, std::uint64_t start_ms, std::uint64_t chunk_ms, std::uint64_t chunks) {
+    std::vector<std::uint8_t> aad(seal_label.begin(), seal_label.end());
+    for (int i = 3; i >= 0; --i) {
+        aad.push_back(static_cast<std::uint8_t>((ver >> (i * 8)) & 0xFFU));
+    }
+    for (const auto v : {start_ms, chunk_ms, chunks}) {
+        for (int i = 7; i >= 0; --i) {
+            aad.push_back(static_cast<std::uint8_t>((v >> (i * 8)) & 0xFFU));
+        }
+    }
+    return aad;
+}
+
+}
+
+Digest leaf_hash(std::span<const std::uint8_t> chunk) {
+    return Hasher().leaf(chunk);
+}
+
+Digest node_hash(const Digest& left, const Digest& right) {
+    return Hasher().node(left, right);
+}
+
+SegmentTree SegmentTree::build(ChunkList chunks, std::uint64_t start_ms, std::uint64_t chunk_ms, std::size_t threads) {
+    if (chunks.empty()) {
+        die("segment has no chunks");
+    }
+    if (chunk_ms == 0) {
+        die("chunk duration must be positive");
+    }
+
+    SegmentTree tree;
+    tree.start_ms_ = start_ms;
+    tree.chunk_ms_ = chunk_ms;
+    tree.levels_.push_back(hash_leaves(chunks, threads));
+
+    Hasher h;
+    while (tree.levels_.back().size() > 1) {
+        const auto& below = tree.levels_.back();
+        std::vector<Digest> up;
+        up.reserve((below.size() + 1) / 2);
+        for (std::size_t i = 0; i + 1 < below.size(); i += 2) {
+            up.push_back(h.node(below[i], below[i + 1]));
+        }
+        if (below.size() % 2 == 1) {
+            up.push_back(below.back());
+        }
+        tree.levels_.push_back(std::move(up));
+    }
+    return tree;
+}
+
+RangeProof SegmentTree::prove(std::uint64_t from_ms, std::uint64_t to_ms) const {
+    if (to_ms <= from_ms || from_ms < start_ms_) {
+        die("range outside segment");
+    }
+    const auto first = (from_ms - start_ms_) / chunk_ms_;
+    const auto last = (to_ms - 1 - start_ms_) / chunk_ms_;
+    if (last >= chunks()) {
+        die("range outside segment");
+    }
+    return prove_chunks(first, last - first + 1);
+}
+
+RangeProof SegmentTree::prove_chunks(std::uint64_t first, std::uint64_t count) const {
+    if (count == 0 || first >= chunks() || count > chunks() - first) {
+        die("range outside segment");
+    }
+
+    RangeProof proof{};
+    proof.first = first;
+    proof.count = count;
+    auto lo = first;
+    auto hi = first + count - 1;
+    for (std::size_t lvl = 0; lvl + 1 < levels_.size(); ++lvl) {
+        const auto& row = levels_[lvl];
+        if (lo % 2 == 1) {
+            proof.nodes.push_back(row[lo - 1]);
+        }
+        if (hi % 2 == 0 && hi + 1 < row.size()) {
+            proof.nodes.push_back(row[hi + 1]);
+        }
+        lo /= 2;
+        hi /= 2;
+    }
+    return proof;
+}
+
+SegmentSeal SegmentTree::seal(const CipherRig& rig, std::uint32_t key_ver) const {
+    SegmentSeal out{};
+    out.key_ver = key_ver;
+    out.start_ms = start_ms_;
+    out.chunk_ms = chunk_ms_;
+    out.chunks = chunks();
+    out.pkt = rig.seal(root(), seal_aad(key_ver, out.start_ms, out.chunk_ms, out.chunks));
+    return out;
+}
+
+bool verify_range(const SegmentSeal& seal, const CipherRig& rig, ChunkList excerpt, const RangeProof& proof) {
+    if (proof.count == 0 || proof.count != excerpt.size() || proof.first >= seal.chunks || proof.count > seal.chunks - proof.first) {
+        return false;
+    }
+
+    SecureBlob root;
+    try {
+        root = rig.open(seal.pkt, seal_aad(seal.key_ver, seal.start_ms, seal.chunk_ms, seal.chunks));
+    } catch (const std::exception&) {
+        return false;
+    }
+    if (root.size() != digest_len) {
+        return false;
+    }
+
+    Hasher h;
+    std::vector<Digest> cur;
+    cur.reserve(excerpt.size() + 2);
+    for (const auto chunk : excerpt) {
+        cur.push_back(h.leaf(chunk));
+    }
+
+    auto lo = proof.first;
+    auto hi = proof.first + proof.count - 1;
+    auto width = seal.chunks;
+    std::size_t used = 0;
+    const auto next = [&]() -> const Digest* { return used < proof.nodes.size() ? &proof.nodes[used++] : nullptr; };
+
+    while (width > 1) {
+        if (lo % 2 == 1) {
+            const auto* left = next();
+            if (!left) {
+                return false;
+            }
+            cur.insert(cur.begin(), *left);
+            --lo;
+        }
+        if (hi % 2 == 0 && hi + 1 < width) {
+            const auto* right = next();
+            if (!right) {
+                return false;
+            }
+            cur.push_back(*right);
+            ++hi;
+        }
+
+        std::vector<Digest> up;
+        up.reserve((cur.size() + 1) / 2);
+        for (std::size_t i = 0; i + 1 < cur.size(); i += 2) {
+            up.push_back(h.node(cur[i], cur[i + 1]));
+        }
+        if (cur.size() % 2 == 1) {
+            up.push_back(cur.back());
+        }
+        cur = std::move(up);
+        lo /= 2;
+        hi /= 2;
+        width = (width + 1) / 2;
+    }
+
+    return used == proof.nodes.size() && cur.size() == 1 && CRYPTO_memcmp(cur.front().data(), root.view().data(), digest_len) == 0;
+}
+
+}
@@ -0,0 +1,330 @@
+#include "syncstream/session.hpp"
+
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
+#include <openssl/rand.h>
+
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+namespace syncstream {
+namespace {
+
+constexpr std::string_view full_label = "syncstream-session";
+constexpr std::string_view resume_label = "syncstream-resume";
+constexpr std::string_view proof_label = "syncstream-proof";
+constexpr std::string_view ticket_label = "syncstream-ticket";
+constexpr std::size_t okm_len = key_len * 3;
+
+[[noreturn]] void die(const std::string& msg) {
+    throw std::runtime_error(msg);
+}
+
+void chk(int code, const char* msg) {
+    if (code != 1) {
+        die(msg);
+    }
+}
+
+void put_label(std::vector<std::uint8_t>& out, std::string_view label) {
+    out.insert(out.end(), label.begin(), label.end());
+}
+
+void put_u32(std::vector<std::uint8_t>& out, std::uint32_t v) {
+    for (int i = 3; i >= 0; --i) {
+        out.push_back(static_cast<std::uint8_t>((v >> (i * 8)) & 0xFFU));
+    }
+}
+
+void put_u64(std::vector<std::uint8_t>& out, std::uint64_t v) {
+    for (int i = 7; i >= 0; --i) {
+        out.push_back(static_cast<std::uint8_t>((v >> (i * 8)) & 0xFFU));
+    }
+}
+
+void put_bytes(std::vector<std::uint8_t>& out, std::span<const std::uint8_t> data) {
+    out.insert(out.end(), data.begin(), data.end());
+}
+
+void put_dev(std::vector<std::uint8_t>& out, const DevId& dev) {
+    if (dev.size() > 0xFFFFU) {
+        die("device id too long");
+    }
+    out.push_back(static_cast<std::uint8_t>((dev.size() >> 8) & 0xFFU));
+    out.push_back(static_cast<std::uint8_t>(dev.size() & 0xFFU));
+    std::transform(dev.begin(), dev.end(), std::back_inserter(out), [](char c) { return static_cast<std::uint8_t>(c); });
+}
+
+void fill_random(std::span<std::uint8_t> out) {
+    chk(RAND_bytes(out.data(), static_cast<int>(out.size())), "session nonce failed");
+}
+
+std::array<std::uint8_t, pub_len> gen_x25519(SecureBlob& priv) {
+    EVP_PKEY_CTX* ctx = EVP_PKEY_CTX_new_id(EVP_PKEY_X25519, nullptr);
+    if (!ctx) {
+        die("x25519 context failed");
+    }
+    EVP_PKEY* pkey = nullptr;
+    const int ok = EVP_PKEY_keygen_init(ctx) == 1 && EVP_PKEY_keygen(ctx, &pkey) == 1 ? 1 : 0;
+    EVP_PKEY_CTX_free(ctx);
+    chk(ok, "x25519 keygen failed");
+
+    std::array<std::uint8_t, pub_len> pub{};
+    SecureBlob raw(pub_len);
+    std::size_t pub_n = pub.size();
+    std::size_t priv_n = raw.size();
+    const int got = EVP_PKEY_get_raw_public_key(pkey, pub.data(), &pub_n) == 1 && EVP_PKEY_get_raw_private_key(pkey, raw.bytes().data(), &priv_n) == 1 ? 1 : 0;
+    EVP_PKEY_free(pkey);
+    chk(got, "x25519 export failed");
+    priv = std::move(raw);
+    return pub;
+}
+
+SecureBlob x25519(const SecureBlob& priv, std::span<const std::uint8_t, pub_len> peer) {
+    EVP_PKEY* mine = EVP_PKEY_new_raw_private_key(EVP_PKEY_X25519, nullptr, priv.view().data(), priv.size());
+    EVP_PKEY* theirs = EVP_PKEY_new_raw_public_key(EVP_PKEY_X25519, nullptr, peer.data(), peer.size());
+    EVP_PKEY_CTX* ctx = mine ? EVP_PKEY_CTX_new(mine, nullptr) : nullptr;
+
+    SecureBlob shared(pub_len);
+    std::size_t n = shared.size();
+    const int ok = ctx && theirs && EVP_PKEY_derive_init(ctx) == 1 && EVP_PKEY_derive_set_peer(ctx, theirs) == 1 && EVP_PKEY_derive(ctx, shared.bytes().data(), &n) == 1 ? 1 : 0;
+    EVP_PKEY_CTX_free(ctx);
+    EVP_PKEY_free(theirs);
+    EVP_PKEY_free(mine);
+    chk(ok, "x25519 derive failed");
+
+    const auto view = shared.view();
+    if (n != pub_len || std::all_of(view.begin(), view.end(), [](std::uint8_t b) { return b == 0; })) {
+        die("x25519 low order point");
+    }
+    return shared;
+}
+
+std::vector<std::uint8_t> full_info(const Hello& hello, const Welcome& welcome) {
+    std::vector<std::uint8_t> info;
+    info.reserve(full_label.size() + hello.dev.size() + 4 + pub_len * 2 + salt_len * 2);
+    put_label(info, full_label);
+    put_dev(info, hello.dev);
+    put_u32(info, hello.key_ver);
+    put_bytes(info, hello.pub);
+    put_bytes(info, welcome.pub);
+    put_bytes(info, hello.nonce);
+    put_bytes(info, welcome.nonce);
+    return info;
+}
+
+std::vector<std::uint8_t> resume_info(const Hello& hello, const Welcome& welcome) {
+    std::vector<std::uint8_t> info;
+    info.reserve(resume_label.size() + hello.dev.size() + 4 + tag_len + salt_len * 2);
+    put_label(info, resume_label);
+    put_dev(info, hello.dev);
+    put_u32(info, hello.key_ver);
+    put_bytes(info, hello.ticket->pkt.mac);
+    put_bytes(info, hello.nonce);
+    put_bytes(info, welcome.nonce);
+    return info;
+}
+
+std::vector<std::uint8_t> ticket_aad(std::uint32_t ver, std::uint64_t issued_ms) {
+    std::vector<std::uint8_t> aad;
+    aad.reserve(ticket_label.size() + 12);
+    put_label(aad, ticket_label);
+    put_u32(aad, ver);
+    put_u64(aad, issued_ms);
+    return aad;
+}
+
+SecureBlob derive(std::span<const std::uint8_t> ikm, const Keychain& keys, std::uint32_t ver, std::span<const std::uint8_t> info) {
+    auto psk = keys.take(ver);
+    SecureBlob okm(okm_len);
+    hkdf_sha256(ikm, psk, info, okm.bytes());
+    OPENSSL_cleanse(psk.data(), psk.size());
+    return okm;
+}
+
+std::array<std::uint8_t, key_len> proof_of(const SecureBlob& okm) {
+    std::array<std::uint8_t, key_len> proof{};
+    const std::span<const std::uint8_t> label(reinterpret_cast<const std::uint8_t*>(proof_label.data()), proof_label.size());
+    hkdf_sha256(okm.view().subspan(key_len, key_len), label, label, proof);
+    return proof;
+}
+
+}
+
+SessionGate::SessionGate(Keychain& keys, std::chrono::milliseconds ticket_life, std::shared_ptr<const Clock> clock)
+    : keys_(keys),
+      clock_(std::move(clock)),
+      life_(static_cast<std::uint64_t>(ticket_life.count())),
+      spent_(ticket_life, 1024) {
+    if (!clock_) {
+        die("clock missing");
+    }
+    if (ticket_life.count() <= 0) {
+        die("ticket life must be positive");
+    }
+}
+
+Accepted SessionGate::accept(const Hello& hello) {
+    const auto now = clock_->now_ms();
+    Accepted out{};
+    fill_random(out.welcome.nonce);
+
+    std::optional<SecureBlob> resume;
+    if (hello.ticket) {
+        resume = redeem(hello, now);
+    }
+
+    SecureBlob okm;
+    try {
+        if (resume) {
+            okm = derive(resume->view(), keys_, hello.key_ver, resume_info(hello, out.welcome));
+            out.welcome.resumed = true;
+        } else {
+            SecureBlob priv;
+            out.welcome.pub = gen_x25519(priv);
+            const auto shared = x25519(priv, hello.pub);
+            okm = derive(shared.view(), keys_, hello.key_ver, full_info(hello, out.welcome));
+        }
+    } catch (...) {
+        rejected_.fetch_add(1, std::memory_order_relaxed);
+        throw;
+    }
+
+    out.welcome.proof = proof_of(okm);
+    out.welcome.ticket = issue(hello.dev.str(), okm.view().subspan(key_len * 2, key_len), now);
+    out.key = SecureBlob::copy_of(okm.view().first(key_len));
+    (out.welcome.resumed ? resumed_ : full_).fetch_add(1, std::memory_order_relaxed);
+    return out;
+}
+
+SessionStats SessionGate::stats() const {
+    return SessionStats{full_.load(std::memory_order_relaxed), resumed_.load(std::memory_order_relaxed), rejected_.load(std::memory_order_relaxed)};
+}
+
+std::optional<SecureBlob> SessionGate::redeem(const Hello& hello, std::uint64_t now) {
+    const auto& ticket = *hello.ticket;
+    if (ticket.issued_ms > now || now - ticket.issued_ms >= life_) {
+        rejected_.fetch_add(1, std::memory_order_relaxed);
+        return std::nullopt;
+    }
+
+    SecureBlob plain;
+    try {
+        plain = rig_for(ticket.key_ver)->open(ticket.pkt, ticket_aad(ticket.key_ver, ticket.issued_ms));
+    } catch (const std::exception&) {
+        rejected_.fetch_add(1, std::memory_order_relaxed);
+        return std::nullopt;
+    }
+
+    const auto view = plain.view();
+    const auto dev = view.size() < key_len ? view.first(0) : view.subspan(key_len);
+    if (view.size() < key_len || !std::equal(dev.begin(), dev.end(), hello.dev.begin(), hello.dev.end(), [](std::uint8_t a, char b) { return a == static_cast<std::uint8_t>(b); })) {
+        rejected_.fetch_add(1, std::memory_order_relaxed);
+        return std::nullopt;
+    }
+
+    {
+        std::scoped_lock lock(mu_);
+        if (spent_.seen_or_mark(ReplayKey::of(ticket.issued_ms, ticket.pkt), ticket.issued_ms, now)) {
+            rejected_.fetch_add(1, std::memory_order_relaxed);
+            return std::nullopt;
+        }
+    }
+    return SecureBlob::copy_of(view.first(key_len));
+}
+
+Ticket SessionGate::issue(std::string_view dev, std::span<const std::uint8_t> resume, std::uint64_t now) {
+    const auto ver = keys_.active();
+    SecureBlob plain(key_len + dev.size());
+    auto out = plain.bytes();
+    std::copy(resume.begin(), resume.end(), out.begin());
+    std::transform(dev.begin(), dev.end(), out.begin() + static_cast<std::ptrdiff_t>(key_len), [](char c) { return static_cast<std::uint8_t>(c); });
+
+    Ticket ticket{};
+    ticket.key_ver = ver;
+    ticket.issued_ms = now;
+    ticket.pkt = rig_for(ver)->seal(plain.view(), ticket_aad(ver, now));
+    return ticket;
+}
+
+std::shared_ptr<const CipherRig> SessionGate::rig_for(std::uint32_t ver) {
+    try {
+        const auto suite = keys_.suite(ver);
+        {
+            std::scoped_lock lock(mu_);
+            const auto it = rigs_.find(ver);
+            if (it != rigs_.end() && it->second->suite() == suite) {
+                return it->second;
+            }
+        }
+        auto rig = std::make_shared<const CipherRig>(keys_.take(ver), suite);
+        std::scoped_lock lock(mu_);
+        std::erase_if(rigs_, [this](const auto& kv) { return !keys_.has(kv.first); });
+        rigs_[ver] = rig;
+        return rig;
+    } catch (const std::exception&) {
+        std::scoped_lock lock(mu_);
+        rigs_.erase(ver);
+        throw;
+    }
+}
+
+std::size_t SessionGate::cached_rigs() const {
+    std::scoped_lock lock(mu_);
+    return rigs_.size();
+}
+
+SessionClient::SessionClient(Keychain& keys, DevId dev) : keys_(keys), dev_(std::move(dev)) {
+    if (dev_.empty()) {
+        die("device id missing");
+    }
+}
+
+Hello SessionClient::hello() {
+    Hello out{};
+    out.dev = dev_;
+    out.key_ver = keys_.active();
+    out.pub = gen_x25519(eph_);
+    fill_random(out.nonce);
+    out.ticket = ticket_;
+    sent_ = out;
+    return out;
+}
+
+SecureBlob SessionClient::finish(const Welcome& welcome) {
+    if (eph_.size() == 0) {
+        die("no hello pending");
+    }
+
+    SecureBlob okm;
+    if (welcome.resumed) {
+        if (!sent_.ticket) {
+            die("unexpected resumption");
+        }
+        okm = derive(resume_.view(), keys_, sent_.key_ver, resume_info(sent_, welcome));
+    } else {
+        const auto shared = x25519(eph_, welcome.pub);
+        okm = derive(shared.view(), keys_, sent_.key_ver, full_info(sent_, welcome));
+    }
+    eph_ = SecureBlob();
+
+    const auto proof = proof_of(okm);
+    if (CRYPTO_memcmp(proof.data(), welcome.proof.data(), proof.size()) != 0) {
+        forget();
+        die("session proof mismatch");
+    }
+
+    ticket_ = welcome.ticket;
+    resume_ = SecureBlob::copy_of(okm.view().subspan(key_len * 2, key_len));
+    return SecureBlob::copy_of(okm.view().first(key_len));
+}
+
+void SessionClient::forget() {
+    ticket_.reset();
+    resume_ = SecureBlob();
+}
+
+}
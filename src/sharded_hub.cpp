@@ -0,0 +1,185 @@
+#include "syncstream/sharded_hub.hpp"
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include <algorithm>
+#include <cassert>
+#include <functional>
+#include <stdexcept>
+
+namespace syncstream {
+namespace {
+
+constexpr int spin_rounds = 64;
+
+[[noreturn]] void die(const std::string& msg) {
+    throw std::runtime_error(msg);
+}
+
+void pin_to(std::jthread& worker, std::size_t cpu) {
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu % CPU_SETSIZE, &set);
+    static_cast<void>(pthread_setaffinity_np(worker.native_handle(), sizeof(set), &set));
+#else
+    static_cast<void>(worker);
+    static_cast<void>(cpu);
+#endif
+}
+
+}
+
+ShardedHub::Shard::Shard(std::array<std::uint8_t, key_len> master, std::chrono::milliseconds max_skew, std::size_t replay_hint, std::size_t burst,
+                         std::size_t refill_per_sec, std::size_t ring_depth, std::chrono::milliseconds overlap, std::shared_ptr<const Clock> clock)
+    : hub(master, max_skew, replay_hint, burst, refill_per_sec, overlap, std::move(clock)), in(ring_depth), out(ring_depth) {}
+
+ShardedHub::ShardedHub(std::array<std::uint8_t, key_len> master, std::chrono::milliseconds max_skew, std::size_t replay_hint, std::size_t burst,
+                       std::size_t refill_per_sec, std::size_t shards, std::size_t ring_depth, bool pin, std::chrono::milliseconds overlap,
+                       std::shared_ptr<const Clock> clock) {
+    if (shards == 0) {
+        die("shard count must be positive");
+    }
+    if (ring_depth == 0) {
+        die("ring depth must be positive");
+    }
+
+    const auto per_shard = std::max<std::size_t>(replay_hint / shards, 1);
+    const auto cpus = std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+    shards_.reserve(shards);
+    for (std::size_t i = 0; i < shards; ++i) {
+        auto shard = std::make_unique<Shard>(master, max_skew, per_shard, burst, refill_per_sec, ring_depth, overlap, clock);
+        auto& ref = *shard;
+        shard->worker = std::jthread([&ref](std::stop_token stop) { run(ref, stop); });
+        if (pin) {
+            pin_to(shard->worker, i % cpus);
+        }
+        shards_.push_back(std::move(shard));
+    }
+}
+
+ShardedHub::~ShardedHub() {
+    for (auto& shard : shards_) {
+        shard->worker.request_stop();
+        shard->bell.fetch_add(1);
+        shard->bell.notify_one();
+    }
+    for (auto& shard : shards_) {
+        shard->worker.join();
+    }
+}
+
+void ShardedHub::stage_key(std::uint32_t ver, std::span<const std::uint8_t> salt, std::span<const std::uint8_t> ctx, bool activate_now, Suite suite) {
+    for (auto& shard : shards_) {
+        shard->hub.stage_key(ver, salt, ctx, activate_now, suite);
+    }
+}
+
+void ShardedHub::activate_key(std::uint32_t ver) {
+    for (auto& shard : shards_) {
+        shard->hub.activate_key(ver);
+    }
+}
+
+void ShardedHub::allow_cmd(Cmd cmd) {
+    for (auto& shard : shards_) {
+        shard->hub.allow_cmd(cmd);
+    }
+}
+
+std::size_t ShardedHub::shard_of(std::string_view dev) const {
+    return std::hash<std::string_view>{}(dev) % shards_.size();
+}
+
+void ShardedHub::claim(std::atomic<std::thread::id>& owner) {
+#ifndef NDEBUG
+    std::thread::id held{};
+    const auto me = std::this_thread::get_id();
+    if (!owner.compare_exchange_strong(held, me, std::memory_order_relaxed)) {
+        assert(held == me && "sharded hub ring used from a second thread");
+    }
+#else
+    static_cast<void>(owner);
+#endif
+}
+
+bool ShardedHub::submit(std::uint64_t tag, std::string_view dev, const VersionedEnv& env) {
+    claim(submitter_);
+    auto& shard = *shards_[shard_of(dev)];
+    if (!shard.in.push(Job{tag, dev, env})) {
+        return false;
+    }
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (shard.sleeping.load(std::memory_order_relaxed)) {
+        shard.bell.fetch_add(1, std::memory_order_relaxed);
+        shard.bell.notify_one();
+    }
+    return true;
+}
+
+std::size_t ShardedHub::poll(std::vector<Opened>& out, std::size_t max) {
+    claim(poller_);
+    std::size_t got = 0;
+    Opened item;
+    for (std::size_t n = 0; n < shards_.size() && got < max; ++n) {
+        auto& shard = *shards_[(next_poll_ + n) % shards_.size()];
+        while (got < max && shard.out.pop(item)) {
+            out.push_back(std::move(item));
+            ++got;
+        }
+    }
+    next_poll_ = (next_poll_ + 1) % shards_.size();
+    return got;
+}
+
+std::uint64_t ShardedHub::handled(std::size_t shard) const {
+    return shards_.at(shard)->handled.load(std::memory_order_relaxed);
+}
+
+void ShardedHub::run(Shard& shard, std::stop_token stop) {
+    Job job;
+    int idle = 0;
+    while (!stop.stop_requested()) {
+        if (shard.in.pop(job)) {
+            idle = 0;
+            Opened res;
+            res.tag = job.tag;
+            try {
+                auto ctrl = shard.hub.open(job.env);
+                if (ctrl.dev == job.dev) {
+                    res.ctrl = std::move(ctrl);
+                } else {
+                    res.err = "shard hint mismatch";
+                }
+            } catch (const std::exception& ex) {
+                res.err = ex.what();
+            }
+            shard.handled.fetch_add(1, std::memory_order_relaxed);
+            while (!shard.out.push(std::move(res))) {
+                if (stop.stop_requested()) {
+                    return;
+                }
+                std::this_thread::yield();
+            }
+            continue;
+        }
+
+        if (++idle < spin_rounds) {
+            std::this_thread::yield();
+            continue;
+        }
+        const auto bell = shard.bell.load(std::memory_order_relaxed);
+        shard.sleeping.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (shard.in.empty() && !stop.stop_requested()) {
+            shard.bell.wait(bell);
+        }
+        shard.sleeping.store(false, std::memory_order_relaxed);
+        idle = 0;
+    }
+}
+
+}
@@ -0,0 +1,236 @@
+#include "syncstream/shm_replay.hpp"
+
+#include <openssl/rand.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define SYNCSTREAM_POSIX_SHM 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace syncstream {
+namespace {
+
+constexpr std::uint64_t shm_magic = 0x5353'5250'4c59'0001ULL;
+constexpr std::uint64_t state_ready = 2;
+constexpr std::size_t probe_len = 16;
+
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "shared replay table needs address-free 64-bit atomics");
+
+[[noreturn]] void die(const std::string& msg) {
+    throw std::runtime_error(msg);
+}
+
+std::uint64_t pow2_at_least(std::uint64_t n) {
+    std::uint64_t v = 1;
+    while (v < n) {
+        v <<= 1;
+    }
+    return v;
+}
+
+std::uint64_t word_of(std::uint64_t epoch, std::uint64_t fp) {
+    return (epoch << 32) | fp;
+}
+
+}
+
+struct ShmReplay::Head {
+    std::atomic<std::uint64_t> state;
+    std::uint64_t magic;
+    std::uint64_t per_part;
+    std::uint64_t parts;
+    std::uint64_t span;
+    std::uint64_t window;
+    std::uint64_t seed;
+    std::uint64_t pad;
+};
+
+ShmReplay::ShmReplay(const std::string& name, std::size_t slots, std::chrono::milliseconds window) {
+#if defined(SYNCSTREAM_POSIX_SHM)
+    if (slots == 0) {
+        die("shm replay needs slots");
+    }
+    const std::uint64_t win = static_cast<std::uint64_t>(std::max<std::int64_t>(window.count(), 0));
+    const std::uint64_t span = replay_span(window);
+    const std::uint64_t parts = 2 * win / span + 3;
+    const std::uint64_t per_part = pow2_at_least(std::max<std::uint64_t>(probe_len, (slots + parts - 1) / parts));
+    map_len_ = sizeof(Head) + static_cast<std::size_t>(parts * per_part) * sizeof(std::atomic<std::uint64_t>);
+
+    fd_ = shm_open(name.c_str(), O_CREAT | O_RDWR, 0600);
+    if (fd_ < 0) {
+        die("shm replay open failed");
+    }
+    struct stat st {};
+    if (fstat(fd_, &st) != 0) {
+        close(fd_);
+        die("shm replay stat failed");
+    }
+    if (st.st_size == 0 && ftruncate(fd_, static_cast<off_t>(map_len_)) != 0) {
+        close(fd_);
+        die("shm replay size failed");
+    }
+    if (fstat(fd_, &st) != 0 || static_cast<std::size_t>(st.st_size) != map_len_) {
+        close(fd_);
+        die("shm replay geometry mismatch");
+    }
+    void* raw = mmap(nullptr, map_len_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (raw == MAP_FAILED) {
+        close(fd_);
+        die("shm replay map failed");
+    }
+    head_ = static_cast<Head*>(raw);
+    table_ = reinterpret_cast<std::atomic<std::uint64_t>*>(static_cast<std::uint8_t*>(raw) + sizeof(Head));
+
+    std::uint64_t idle = 0;
+    if (head_->state.compare_exchange_strong(idle, 1, std::memory_order_acq_rel)) {
+        std::uint64_t seed = 0;
+        if (RAND_bytes(reinterpret_cast<unsigned char*>(&seed), sizeof(seed)) != 1) {
+            head_->state.store(0, std::memory_order_release);
+            die("shm replay seed failed");
+        }
+        head_->magic = shm_magic;
+        head_->per_part = per_part;
+        head_->parts = parts;
+        head_->span = span;
+        head_->window = win;
+        head_->seed = seed;
+        head_->state.store(state_ready, std::memory_order_release);
+    } else {
+        for (int spin = 0; head_->state.load(std::memory_order_acquire) != state_ready; ++spin) {
+            if (spin == 1000) {
+                munmap(raw, map_len_);
+                close(fd_);
+                die("shm replay init stalled");
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    if (head_->magic != shm_magic || head_->per_part != per_part || head_->parts != parts || head_->window != win) {
+        munmap(raw, map_len_);
+        close(fd_);
+        die("shm replay geometry mismatch");
+    }
+#else
+    static_cast<void>(name);
+    static_cast<void>(slots);
+    static_cast<void>(window);
+    die("shm replay unsupported on this platform");
+#endif
+}
+
+ShmReplay::~ShmReplay() {
+#if defined(SYNCSTREAM_POSIX_SHM)
+    if (head_ != nullptr) {
+        munmap(head_, map_len_);
+    }
+    if (fd_ >= 0) {
+        close(fd_);
+    }
+#endif
+}
+
+void ShmReplay::unlink(const std::string& name) {
+#if defined(SYNCSTREAM_POSIX_SHM)
+    static_cast<void>(shm_unlink(name.c_str()));
+#else
+    static_cast<void>(name);
+#endif
+}
+
+std::size_t ShmReplay::capacity() const {
+    return static_cast<std::size_t>(head_->parts * head_->per_part);
+}
+
+std::uint64_t ShmReplay::window() const {
+    return head_->window;
+}
+
+bool ShmReplay::expired(std::uint64_t epoch, std::uint64_t now) const {
+    return (epoch + 1) * head_->span + head_->window <= now;
+}
+
+std::atomic<std::uint64_t>* ShmReplay::part(std::uint64_t epoch) const {
+    return table_ + (epoch % head_->parts) * head_->per_part;
+}
+
+bool ShmReplay::holds(std::uint64_t h, std::uint64_t fp, std::uint64_t epoch) const {
+    const std::uint64_t tag = epoch & 0xFFFF'FFFFULL;
+    const std::uint64_t mine = word_of(tag, fp);
+    const std::uint64_t mask = head_->per_part - 1;
+    const auto* slots = part(epoch);
+    for (std::size_t i = 0; i < probe_len; ++i) {
+        const auto cur = slots[(h + i) & mask].load(std::memory_order_acquire);
+        if (cur == mine) {
+            return true;
+        }
+        if (cur == 0 || (cur >> 32) != tag) {
+            return false;
+        }
+    }
+    return false;
+}
+
+bool ShmReplay::seen_or_mark(const ReplayKey& key, std::uint64_t at_ms, std::uint64_t now) {
+    const std::uint64_t epoch = at_ms / head_->span;
+    if (expired(epoch, now)) {
+        die("replay window passed");
+    }
+    const std::uint64_t tag = epoch & 0xFFFF'FFFFULL;
+    const std::uint64_t h = replay_hash(key, head_->seed);
+    std::uint64_t fp = h >> 32;
+    if (fp == 0) {
+        fp = 1;
+    }
+    if ((epoch > 0 && holds(h, fp, epoch - 1)) || holds(h, fp, epoch + 1)) {
+        return true;
+    }
+    const std::uint64_t mine = word_of(tag, fp);
+    const std::uint64_t mask = head_->per_part - 1;
+    auto* slots = part(epoch);
+
+    for (std::size_t i = 0; i < probe_len; ++i) {
+        auto& slot = slots[(h + i) & mask];
+        std::uint64_t cur = slot.load(std::memory_order_acquire);
+        for (;;) {
+            if (cur == mine) {
+                return true;
+            }
+            if (cur != 0 && (cur >> 32) == tag) {
+                break;
+            }
+            if (slot.compare_exchange_weak(cur, mine, std::memory_order_acq_rel, std::memory_order_acquire)) {
+                return false;
+            }
+        }
+    }
+    die("shm replay table full");
+}
+
+std::size_t ShmReplay::size(std::uint64_t now) const {
+    const std::uint64_t lo = now >= head_->window ? (now - head_->window) / head_->span : 0;
+    const std::uint64_t hi = (now + head_->window) / head_->span;
+    std::size_t n = 0;
+    for (std::uint64_t epoch = lo; epoch <= hi; ++epoch) {
+        if (expired(epoch, now)) {
+            continue;
+        }
+        const std::uint64_t tag = epoch & 0xFFFF'FFFFULL;
+        const auto* slots = part(epoch);
+        for (std::uint64_t i = 0; i < head_->per_part; ++i) {
+            const auto cur = slots[i].load(std::memory_order_relaxed);
+            if (cur != 0 && (cur >> 32) == tag) {
+                ++n;
+            }
+        }
+    }
+    return n;
+}
+
+}
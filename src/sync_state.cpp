@@ -0,0 +1,202 @@
+#include "syncstream/sync_state.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+namespace syncstream {
+namespace {
+
+constexpr std::size_t delta_head = 4 + 1;
+constexpr std::uint32_t max_gap = std::numeric_limits<std::uint8_t>::max();
+
+[[noreturn]] void die(const std::string& msg) {
+    throw std::runtime_error(msg);
+}
+
+}
+
+std::optional<SyncDelta> read_delta(std::span<const std::uint8_t> body) {
+    if (body.size() < delta_head + 1) {
+        return std::nullopt;
+    }
+    std::uint32_t ver = 0;
+    for (std::size_t i = 0; i < 4; ++i) {
+        ver = (ver << 8) | body[i];
+    }
+    const std::uint32_t gap = body[4];
+    if (ver == 0 || gap > ver) {
+        return std::nullopt;
+    }
+    return SyncDelta{ver, gap, body.subspan(delta_head)};
+}
+
+bool BodyLayout<SyncDelta>::fits(std::span<const std::uint8_t> body) {
+    const auto msg = read_delta(body);
+    SyncBody cfg{Res::p480, 1, 0, 0, false, false};
+    return msg && apply_delta(cfg, msg->delta, msg->gap == 0);
+}
+
+SyncOut SyncSender::stage(const DevId& dev, const SyncBody& cfg, std::uint64_t now) {
+    if (!BodyLayout<SyncBody>::ok(cfg)) {
+        die("sync body invalid");
+    }
+    std::scoped_lock lock(mu_);
+    auto& peer = peers_[std::string(dev.str())];
+    const auto ver = ++peer.next;
+    if (ver == 0) {
+        die("sync version exhausted");
+    }
+
+    std::uint32_t gap = 0;
+    if (peer.acked && ver - peer.acked->first <= max_gap) {
+        gap = ver - peer.acked->first;
+    }
+    const auto delta = encode_delta(gap == 0 ? nullptr : &peer.acked->second, cfg);
+
+    std::vector<std::uint8_t> body;
+    body.reserve(delta_head + delta.size());
+    for (int i = 3; i >= 0; --i) {
+        body.push_back(static_cast<std::uint8_t>((ver >> (i * 8)) & 0xFFU));
+    }
+    body.push_back(static_cast<std::uint8_t>(gap));
+    body.insert(body.end(), delta.begin(), delta.end());
+
+    peer.staged[ver] = cfg;
+    return SyncOut{Ctrl{dev, Cmd::sync_delta, now, Body(body)}, ver, gap == 0};
+}
+
+void SyncSender::sent(std::string_view dev, std::uint32_t ver, const VersionedEnv& env) {
+    std::scoped_lock lock(mu_);
+    const auto it = peers_.find(std::string(dev));
+    if (it == peers_.end() || it->second.staged.find(ver) == it->second.staged.end()) {
+        die("sync version unknown");
+    }
+    it->second.inflight[{env.key_ver, env.env.seq}] = ver;
+}
+
+std::size_t SyncSender::on_ack(std::string_view dev, const Ack& ack) {
+    std::scoped_lock lock(mu_);
+    const auto it = peers_.find(std::string(dev));
+    if (it == peers_.end()) {
+        return 0;
+    }
+    auto& peer = it->second;
+    std::size_t hit = 0;
+    for (auto f = peer.inflight.lower_bound({ack.key_ver, 0}); f != peer.inflight.end() && f->first.first == ack.key_ver;) {
+        if (!ack.covers(f->first.second)) {
+            ++f;
+            continue;
+        }
+        const auto ver = f->second;
+        if (!peer.acked || ver > peer.acked->first) {
+            peer.acked.emplace(ver, peer.staged.at(ver));
+        }
+        f = peer.inflight.erase(f);
+        ++hit;
+    }
+    if (peer.acked) {
+        peer.staged.erase(peer.staged.begin(), peer.staged.upper_bound(peer.acked->first));
+    }
+    return hit;
+}
+
+void SyncSender::lost(std::string_view dev, const VersionedEnv& env) {
+    std::scoped_lock lock(mu_);
+    const auto it = peers_.find(std::string(dev));
+    if (it == peers_.end()) {
+        return;
+    }
+    auto& peer = it->second;
+    const auto f = peer.inflight.find({env.key_ver, env.env.seq});
+    if (f == peer.inflight.end()) {
+        return;
+    }
+    const auto ver = f->second;
+    peer.inflight.erase(f);
+    std::erase_if(peer.staged, [&](const auto& kv) {
+        return kv.first <= ver && std::none_of(peer.inflight.begin(), peer.inflight.end(), [&](const auto& in) { return in.second == kv.first; });
+    });
+}
+
+void SyncSender::reset(std::string_view dev) {
+    std::scoped_lock lock(mu_);
+    const auto it = peers_.find(std::string(dev));
+    if (it != peers_.end()) {
+        it->second.acked.reset();
+        it->second.staged.clear();
+        it->second.inflight.clear();
+    }
+}
+
+std::optional<std::uint32_t> SyncSender::base(std::string_view dev) const {
+    std::scoped_lock lock(mu_);
+    const auto it = peers_.find(std::string(dev));
+    if (it == peers_.end() || !it->second.acked) {
+        return std::nullopt;
+    }
+    return it->second.acked->first;
+}
+
+std::size_t SyncSender::staged(std::string_view dev) const {
+    std::scoped_lock lock(mu_);
+    const auto it = peers_.find(std::string(dev));
+    return it == peers_.end() ? 0 : it->second.staged.size();
+}
+
+SyncMirror::SyncMirror(std::size_t history) : history_(history) {
+    if (history_ == 0) {
+        die("sync history must be positive");
+    }
+}
+
+SyncApply SyncMirror::apply(std::span<const std::uint8_t> body) {
+    const auto msg = read_delta(body);
+    if (!msg) {
+        die("sync delta invalid");
+    }
+    const auto ver = msg->ver;
+    const auto gap = msg->gap;
+
+    std::scoped_lock lock(mu_);
+    SyncBody cfg{};
+    if (gap == 0) {
+        if (!apply_delta(cfg, msg->delta, true)) {
+            die("sync body invalid");
+        }
+        const auto same = std::find_if(kept_.begin(), kept_.end(), [&](const auto& k) { return k.first == ver; });
+        if (same != kept_.end() && same->second == cfg) {
+            return SyncApply::stale;
+        }
+        if (!kept_.empty() && ver <= kept_.back().first) {
+            kept_.clear();
+        }
+    } else {
+        if (!kept_.empty() && ver <= kept_.back().first) {
+            return SyncApply::stale;
+        }
+        const auto base = std::find_if(kept_.begin(), kept_.end(), [&](const auto& k) { return k.first == ver - gap; });
+        if (base == kept_.end()) {
+            return SyncApply::diverged;
+        }
+        cfg = base->second;
+        if (!apply_delta(cfg, msg->delta, false)) {
+            die("sync body invalid");
+        }
+    }
+    kept_.emplace_back(ver, cfg);
+    while (kept_.size() > history_) {
+        kept_.pop_front();
+    }
+    return SyncApply::applied;
+}
+
+std::optional<std::pair<std::uint32_t, SyncBody>> SyncMirror::current() const {
+    std::scoped_lock lock(mu_);
+    if (kept_.empty()) {
+        return std::nullopt;
+    }
+    return kept_.back();
+}
+
+}
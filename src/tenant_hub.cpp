@@ -0,0 +1,201 @@
+#include "syncstream/tenant_hub.hpp"
+#include "syncstream/secure_pool.hpp"
+
+#include <openssl/crypto.h>
+
+#include <memory>
+#include <stdexcept>
+
+namespace syncstream {
+namespace {
+
+constexpr std::size_t node_bytes = 4 * sizeof(void*);
+constexpr std::size_t key_bytes = SecurePool::min_class + node_bytes + 16;
+constexpr std::size_t core_bytes = sizeof(RelayCore) + sizeof(ReplayWheel) + 16 * 64;
+constexpr std::size_t replay_bytes = sizeof(ReplayKey) + node_bytes;
+constexpr std::size_t device_bytes = 64 + node_bytes;
+constexpr std::size_t open_bytes = replay_bytes + device_bytes;
+
+[[noreturn]] void die(const std::string& msg) {
+    throw std::runtime_error(msg);
+}
+
+}
+
+TenantHub::Tenant::Tenant(std::array<std::uint8_t, key_len> master, const TenantConfig& cfg, std::chrono::milliseconds overlap, CoreRing::Build build)
+    : keys(master), rate(cfg.burst, cfg.refill_per_sec, cfg.rate_idle), limit(cfg.max_bytes), ring(keys, overlap, std::move(build)) {}
+
+TenantHub::TenantHub(std::chrono::milliseconds max_skew, std::size_t budget_bytes, std::chrono::milliseconds overlap, std::shared_ptr<const Clock> clock)
+    : max_skew_(max_skew), budget_(budget_bytes), overlap_(overlap), clock_(std::move(clock)) {
+    if (overlap_.count() < 0) {
+        die("overlap cannot be negative");
+    }
+    if (!clock_) {
+        die("clock missing");
+    }
+}
+
+void TenantHub::add_tenant(std::string_view id, std::array<std::uint8_t, key_len> master, TenantConfig cfg) {
+    if (id.empty()) {
+        die("tenant id missing");
+    }
+    if (cfg.max_bytes < sizeof(Tenant) + key_bytes + core_bytes) {
+        OPENSSL_cleanse(master.data(), master.size());
+        die("tenant limit too small");
+    }
+    auto build = [skew = max_skew_, clock = clock_](const std::array<std::uint8_t, key_len>& key, Suite suite) {
+        return std::make_shared<RelayCore>(key, skew, 0, clock, suite);
+    };
+    auto tenant = std::make_shared<Tenant>(master, cfg, overlap_, std::move(build));
+    OPENSSL_cleanse(master.data(), master.size());
+    tenant->bound.store(measure(*tenant).bytes, std::memory_order_relaxed);
+
+    std::unique_lock lock(mu_);
+    if (tenants_.find(id) != tenants_.end()) {
+        die("tenant exists");
+    }
+    if (cfg.max_bytes > budget_ - reserved_) {
+        die("tenant budget exceeded");
+    }
+    tenants_.emplace(std::string(id), std::move(tenant));
+    reserved_ += cfg.max_bytes;
+}
+
+void TenantHub::drop_tenant(std::string_view id) {
+    std::unique_lock lock(mu_);
+    const auto it = tenants_.find(id);
+    if (it == tenants_.end()) {
+        return;
+    }
+    reserved_ -= it->second->limit;
+    tenants_.erase(it);
+}
+
+void TenantHub::stage_key(std::string_view id, std::uint32_t ver, std::span<const std::uint8_t> salt, std::span<const std::uint8_t> ctx, bool activate_now, Suite suite) {
+    const auto t = find(id);
+    t->keys.stage(ver, salt, ctx, suite);
+    {
+        std::scoped_lock lock(t->mu);
+        t->ring.stage(ver, suite);
+    }
+    t->bound.fetch_add(key_bytes, std::memory_order_relaxed);
+    if (activate_now) {
+        activate_key(id, ver);
+    }
+}
+
+void TenantHub::activate_key(std::string_view id, std::uint32_t ver) {
+    const auto t = find(id);
+    const auto now = clock_->now_ms();
+    std::scoped_lock lock(t->mu);
+    t->ring.activate(ver, now);
+}
+
+void TenantHub::allow_cmd(std::string_view id, Cmd cmd) {
+    const auto t = find(id);
+    std::scoped_lock lock(t->mu);
+    t->policy.allow(cmd);
+}
+
+VersionedEnv TenantHub::seal(std::string_view id, const Ctrl& ctrl) {
+    const auto t = find(id);
+    {
+        std::scoped_lock lock(t->mu);
+        if (!t->policy.can(ctrl.cmd)) {
+            die("cmd not allowed");
+        }
+    }
+    const auto now = clock_->now_ms();
+    if (!t->rate.knows(ctrl.dev.str()) && !admit(*t, device_bytes, now)) {
+        die("tenant memory limit");
+    }
+    if (!t->rate.hit(ctrl.dev.str(), now)) {
+        die("rate limited");
+    }
+    const auto ver = t->keys.active();
+    return VersionedEnv{ver, core_for(*t, ver, now)->seal_ctrl(ctrl)};
+}
+
+Ctrl TenantHub::open(std::string_view id, const VersionedEnv& env) {
+    const auto t = find(id);
+    const auto now = clock_->now_ms();
+    const auto core = core_for(*t, env.key_ver, now);
+    if (!admit(*t, open_bytes, now)) {
+        die("tenant memory limit");
+    }
+    auto ctrl = core->open_ctrl(env.env, now);
+    {
+        std::scoped_lock lock(t->mu);
+        if (!t->policy.can(ctrl.cmd)) {
+            die("cmd not allowed");
+        }
+    }
+    if (!t->rate.hit(ctrl.dev.str(), now)) {
+        die("rate limited");
+    }
+    return ctrl;
+}
+
+TenantUsage TenantHub::usage(std::string_view id) const {
+    return measure(*find(id));
+}
+
+std::size_t TenantHub::tenants() const {
+    std::shared_lock lock(mu_);
+    return tenants_.size();
+}
+
+std::size_t TenantHub::reserved() const {
+    std::shared_lock lock(mu_);
+    return reserved_;
+}
+
+std::shared_ptr<TenantHub::Tenant> TenantHub::find(std::string_view id) const {
+    std::shared_lock lock(mu_);
+    const auto it = tenants_.find(id);
+    if (it == tenants_.end()) {
+        die("tenant unknown");
+    }
+    return it->second;
+}
+
+std::shared_ptr<RelayCore> TenantHub::core_for(Tenant& t, std::uint32_t ver, std::uint64_t now) {
+    std::scoped_lock lock(t.mu);
+    const auto had = t.ring.built();
+    auto core = t.ring.core_for(ver, now);
+    if (t.ring.built() > had) {
+        t.bound.fetch_add(core_bytes, std::memory_order_relaxed);
+    }
+    return core;
+}
+
+bool TenantHub::admit(Tenant& t, std::size_t grow, std::uint64_t now) {
+    if (t.bound.fetch_add(grow, std::memory_order_relaxed) + grow <= t.limit) {
+        return true;
+    }
+    if (t.checked.exchange(now, std::memory_order_relaxed) == now) {
+        return false;
+    }
+    const auto bytes = measure(t).bytes + grow;
+    t.bound.store(bytes, std::memory_order_relaxed);
+    return bytes <= t.limit;
+}
+
+TenantUsage TenantHub::measure(const Tenant& t) {
+    TenantUsage out{};
+    out.limit = t.limit;
+    out.devices = t.rate.size();
+    std::size_t keys = 0;
+    {
+        std::scoped_lock lock(t.mu);
+        keys = t.ring.size();
+        t.ring.each([&](const RelayCore& core) {
+            ++out.cores;
+            out.replay += core.replay_size();
+        });
+    }
+    out.bytes = sizeof(Tenant) + keys * key_bytes + out.cores * core_bytes + out.replay * replay_bytes + out.devices * device_bytes;
+    return out;
+}
+
+}
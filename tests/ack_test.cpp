@@ -0,0 +1,190 @@
+#include "syncstream/ack.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+void need(bool ok, const std::string& msg) {
+    if (!ok) {
+        throw std::runtime_error(msg);
+    }
+}
+
+void cumulative_and_selective() {
+    syncstream::AckWindow acks(std::chrono::milliseconds(50), 100);
+    for (const std::uint64_t seq : {1, 2, 4, 5}) {
+        acks.note("cam-1", 1, seq, 0);
+    }
+    auto st = acks.state("cam-1", 1);
+    need(st && st->cum == 2 && st->top == 5 && st->sack == 0b1, "sack bits wrong");
+    need(st->covers(5) && st->covers(4) && !st->covers(3) && !st->covers(70), "covers wrong");
+
+    acks.note("cam-1", 1, 3, 0);
+    st = acks.state("cam-1", 1);
+    need(st->cum == 5 && st->top == 5 && st->sack == 0, "hole fill did not advance");
+    need(!acks.state("cam-1", 2), "key versions share state");
+
+    acks.note("cam-1", 1, 8, 0);
+    acks.note("cam-1", 1, 200, 0);
+    st = acks.state("cam-1", 1);
+    need(st->cum == 5 && st->top == 200, "window slide moved cum over holes");
+    need(st->covers(200) && !st->covers(199) && !st->covers(6), "covers after slide wrong");
+    need(st->abandons(6) && st->abandons(8) && !st->abandons(199) && !st->abandons(3), "overflow not reported");
+
+    const auto back = syncstream::unpack_ack(syncstream::pack_ack(*st).view());
+    need(back.key_ver == 1 && back.cum == st->cum && back.top == st->top && back.sack == st->sack, "ack codec roundtrip");
+    bool hit = false;
+    try {
+        static_cast<void>(syncstream::unpack_ack(std::vector<std::uint8_t>(7, 0)));
+    } catch (const std::exception&) {
+        hit = true;
+    }
+    need(hit, "short ack accepted");
+    hit = false;
+    try {
+        static_cast<void>(syncstream::unpack_ack(syncstream::pack_ack({1, 2, 5, 0b10}).view()));
+    } catch (const std::exception&) {
+        hit = true;
+    }
+    need(hit, "non-cumulative ack accepted");
+}
+
+void batches_return_traffic() {
+    syncstream::AckWindow acks(std::chrono::milliseconds(50), 8);
+    for (std::uint64_t seq = 1; seq <= 20; ++seq) {
+        acks.note("cam-1", 1, seq, 0);
+        acks.note("cam-2", 1, seq, 0);
+    }
+    auto out = acks.due(0);
+    need(out.size() == 2, "full batches not acked once per device");
+    need(out[0].cmd == syncstream::Cmd::ack && syncstream::unpack_ack(out[0].body.view()).cum == 20, "batch ack wrong");
+    need(acks.pending() == 0, "pending not cleared");
+
+    acks.note("cam-1", 1, 21, 10);
+    acks.note("cam-1", 1, 22, 20);
+    need(acks.due(40).empty(), "ack sent before delay");
+    out = acks.due(60);
+    need(out.size() == 1 && out[0].dev == syncstream::DevId("cam-1"), "delayed ack missing");
+    need(syncstream::unpack_ack(out[0].body.view()).cum == 22, "delayed ack stale");
+    need(acks.due(500).empty(), "ack repeated without traffic");
+}
+
+void sealed_ack_clears_retries() {
+    const auto key = syncstream::mint_key();
+    syncstream::RelayCore cam(key, std::chrono::seconds(30));
+    syncstream::RelayCore relay(key, std::chrono::seconds(30));
+    syncstream::AckWindow acks(std::chrono::milliseconds(20), 4);
+    syncstream::RetryBook book(std::chrono::milliseconds(100), std::chrono::seconds(5));
+
+    const auto t0 = syncstream::now_ms();
+    std::vector<syncstream::VersionedEnv> sent;
+    for (std::uint8_t i = 0; i < 6; ++i) {
+        sent.push_back({1, cam.seal_ctrl({"cam-7", syncstream::Cmd::sync, t0, {i}}, book.next_seq("cam-7", 1))});
+        book.track("cam-7", sent.back(), t0);
+    }
+    for (std::size_t i = 0; i < sent.size(); ++i) {
+        if (i == 2) {
+            continue;
+        }
+        const auto ctrl = relay.open_ctrl(sent[i].env, t0);
+        acks.note(ctrl.dev.str(), sent[i].key_ver, sent[i].env.seq, t0);
+    }
+
+    const auto out = acks.due(t0 + 20);
+    need(out.size() == 1, "expected one ack for five envelopes");
+    const auto back = cam.open_ctrl(relay.seal_ctrl(out[0]), t0 + 21);
+    need(back.cmd == syncstream::Cmd::ack, "ack cmd lost");
+    need(book.on_ack(back.dev.str(), syncstream::unpack_ack(back.body.view())) == 5, "acked entries not cleared");
+    need(book.inflight() == 1, "lost envelope not kept");
+
+    need(book.due(t0 + 50).resend.empty(), "resent before rto");
+    auto plan = book.due(t0 + 100);
+    need(plan.resend.size() == 1 && plan.resend[0].env.env.seq == sent[2].env.seq && plan.resend[0].dev.str() == "cam-7", "hole not resent");
+    need(book.due(t0 + 250).resend.empty(), "rto did not back off");
+    need(book.due(t0 + 300).resend.size() == 1, "second resend missing");
+    plan = book.due(t0 + 5000);
+    need(plan.lost.size() == 1 && book.inflight() == 0, "expired envelope not reported");
+}
+
+}
+
+void interleaved_devices() {
+    const auto key = syncstream::mint_key();
+    syncstream::RelayCore phone(key, std::chrono::seconds(30));
+    syncstream::RelayCore relay(key, std::chrono::seconds(30));
+    syncstream::AckWindow acks(std::chrono::milliseconds(20), 100);
+    syncstream::RetryBook book(std::chrono::milliseconds(100), std::chrono::seconds(5));
+
+    const auto t0 = syncstream::now_ms();
+    std::vector<std::pair<std::string, syncstream::VersionedEnv>> sent;
+    for (std::uint8_t i = 0; i < 8; ++i) {
+        const std::string dev = i % 2 == 0 ? "cam-a" : "cam-b";
+        const syncstream::VersionedEnv env{1, phone.seal_ctrl({dev, syncstream::Cmd::arm, t0, {i}}, book.next_seq(dev, 1))};
+        book.track(dev, env, t0);
+        sent.emplace_back(dev, env);
+    }
+    need(sent[0].second.env.seq == 1 && sent[1].second.env.seq == 1 && sent[7].second.env.seq == 4, "per-device seqs not dense");
+    for (std::size_t i = 0; i < sent.size(); ++i) {
+        if (sent[i].first == "cam-b") {
+            continue;
+        }
+        const auto ctrl = relay.open_ctrl(sent[i].second.env, t0);
+        acks.note(ctrl.dev.str(), 1, sent[i].second.env.seq, t0);
+    }
+    const auto out = acks.due(t0 + 20);
+    need(out.size() == 1 && out[0].dev.str() == "cam-a", "ack not scoped to device");
+    const auto ack = syncstream::unpack_ack(out[0].body.view());
+    need(ack.cum == 4, "device stream not contiguous");
+    need(book.on_ack("cam-a", ack) == 4 && book.inflight() == 4, "ack for one device cleared another");
+    need(book.due(t0 + 100).resend.size() == 4, "unacked device not resent");
+}
+
+void overflow_reported_lost() {
+    const auto key = syncstream::mint_key();
+    syncstream::RelayCore cam(key, std::chrono::seconds(30));
+    syncstream::RelayCore relay(key, std::chrono::seconds(30));
+    syncstream::AckWindow acks(std::chrono::milliseconds(20), 8);
+    syncstream::RetryBook book(std::chrono::seconds(1), std::chrono::seconds(60));
+
+    const auto t0 = syncstream::now_ms();
+    std::uint64_t gap = 0;
+    for (std::uint8_t i = 0; i < 100; ++i) {
+        const syncstream::VersionedEnv env{1, cam.seal_ctrl({"cam-9", syncstream::Cmd::ping, t0, {i}}, book.next_seq("cam-9", 1))};
+        book.track("cam-9", env, t0);
+        if (i == 2) {
+            gap = env.env.seq;
+            continue;
+        }
+        acks.note(relay.open_ctrl(env.env, t0).dev.str(), 1, env.env.seq, t0);
+        for (const auto& a : acks.due(t0)) {
+            static_cast<void>(book.on_ack(a.dev.str(), syncstream::unpack_ack(a.body.view())));
+        }
+    }
+    for (const auto& a : acks.due(t0 + 20)) {
+        static_cast<void>(book.on_ack(a.dev.str(), syncstream::unpack_ack(a.body.view())));
+    }
+    need(acks.state("cam-9", 1)->cum == gap - 1, "cum moved past a hole");
+    const auto plan = book.due(t0 + 10);
+    need(plan.lost.size() == 1 && plan.lost[0].env.env.seq == gap, "hole past the window not reported lost");
+    need(book.inflight() == 0, "abandoned entry kept");
+}
+
+int main() {
+    try {
+        cumulative_and_selective();
+        batches_return_traffic();
+        sealed_ack_clears_retries();
+        interleaved_devices();
+        overflow_reported_lost();
+        std::cout << "ack tests passed\n";
+        return 0;
+    } catch (const std::exception& ex) {
+        std::cerr << ex.what() << '\n';
+        return 1;
+    }
+}
@@ -0,0 +1,160 @@
+#include "syncstream/async.hpp"
+#include "syncstream/edge_hub.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+void need(bool ok, const std::string& msg) {
+    if (!ok) {
+        throw std::runtime_error(msg);
+    }
+}
+
+syncstream::Task<int> add_later(syncstream::Executor& ex, int a, int b) {
+    co_await ex.schedule();
+    co_return a + b;
+}
+
+syncstream::Task<int> chain(syncstream::Executor& ex) {
+    const int x = co_await add_later(ex, 1, 2);
+    const int y = co_await add_later(ex, x, 4);
+    co_return y;
+}
+
+syncstream::Task<> fail_later(syncstream::Executor& ex) {
+    co_await ex.schedule();
+    throw std::runtime_error("boom");
+}
+
+void tasks_compose() {
+    syncstream::PoolExecutor pool(2);
+    need(syncstream::sync_wait(chain(pool)) == 7, "task chain result wrong");
+
+    bool hit = false;
+    try {
+        syncstream::sync_wait(fail_later(pool));
+    } catch (const std::runtime_error&) {
+        hit = true;
+    }
+    need(hit, "task exception not propagated");
+}
+
+syncstream::Task<> bump(syncstream::AsyncMutex& mu, syncstream::Executor& ex, int& shared, std::atomic<int>& inside) {
+    const auto guard = co_await mu.lock(ex);
+    need(inside.fetch_add(1) == 0, "async mutex admitted two holders");
+    ++shared;
+    std::this_thread::sleep_for(std::chrono::microseconds(50));
+    inside.fetch_sub(1);
+}
+
+syncstream::Task<> bump_many(syncstream::AsyncMutex& mu, syncstream::Executor& ex, int& shared, std::atomic<int>& inside) {
+    co_await ex.schedule();
+    for (int i = 0; i < 50; ++i) {
+        co_await bump(mu, ex, shared, inside);
+    }
+}
+
+void async_mutex_excludes() {
+    syncstream::PoolExecutor pool(4);
+    syncstream::AsyncMutex mu;
+    int shared = 0;
+    std::atomic<int> inside{0};
+    std::vector<std::thread> callers;
+    for (int i = 0; i < 4; ++i) {
+        callers.emplace_back([&] { syncstream::sync_wait(bump_many(mu, pool, shared, inside)); });
+    }
+    for (auto& t : callers) {
+        t.join();
+    }
+    need(shared == 200, "async mutex lost updates");
+}
+
+syncstream::Task<int> guarded(syncstream::AsyncMutex& mu, syncstream::Executor& ex, int& shared) {
+    const auto guard = co_await mu.lock(ex);
+    co_return ++shared;
+}
+
+void contended_lock_parks() {
+    syncstream::PoolExecutor pool(1);
+    syncstream::AsyncMutex mu;
+    int shared = 0;
+    mu.lock();
+    std::thread waiter([&] { need(syncstream::sync_wait(guarded(mu, pool, shared)) == 1, "parked lock result wrong"); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    need(syncstream::sync_wait(add_later(pool, 2, 3)) == 5, "contended lock pinned the worker");
+    need(shared == 0, "lock ignored blocking holder");
+    mu.unlock();
+    waiter.join();
+    need(shared == 1, "parked waiter never ran");
+
+    syncstream::InlineExecutor inline_ex;
+    need(syncstream::sync_wait(chain(inline_ex)) == 7, "inline chain result wrong");
+    need(syncstream::sync_wait(guarded(mu, inline_ex, shared)) == 2, "inline lock failed");
+
+    std::thread blocker([&] {
+        for (int i = 0; i < 100; ++i) {
+            std::scoped_lock lock(mu);
+            ++shared;
+        }
+    });
+    for (int i = 0; i < 100; ++i) {
+        static_cast<void>(syncstream::sync_wait(guarded(mu, pool, shared)));
+    }
+    blocker.join();
+    need(shared == 202, "blocking and parked holders overlapped");
+}
+
+void hub_async_flow() {
+    syncstream::PoolExecutor pool(2);
+    const auto master = syncstream::mint_key();
+    syncstream::EdgeHub tx(master, std::chrono::seconds(30), 2048, 200, 200);
+    syncstream::EdgeHub rx(master, std::chrono::seconds(30), 2048, 200, 200);
+    syncstream::sync_wait(tx.stage_key_async(3, {1, 2}, {'a'}, true, pool));
+    syncstream::sync_wait(rx.stage_key_async(3, {1, 2}, {'a'}, true, pool));
+    tx.allow_cmd(syncstream::Cmd::sync);
+    rx.allow_cmd(syncstream::Cmd::sync);
+    rx.coalesce(std::chrono::milliseconds(1));
+
+    syncstream::Ctrl ctrl{"ws-cam", syncstream::Cmd::sync, syncstream::now_ms(), {'h', 'd'}};
+    const auto env = syncstream::sync_wait(tx.seal_async(ctrl, pool));
+    need(env.key_ver == 3, "async staging not active");
+    const auto out = syncstream::sync_wait(rx.open_async(env, pool));
+    need(out.body == ctrl.body, "async open mismatch");
+
+    bool hit = false;
+    try {
+        static_cast<void>(syncstream::sync_wait(rx.open_async(env, pool)));
+    } catch (...) {
+        hit = true;
+    }
+    need(hit, "async replay not blocked");
+
+    rx.submit(syncstream::sync_wait(tx.seal_async(ctrl, pool)));
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    need(syncstream::sync_wait(rx.drain_async(pool)).size() == 1, "async drain lost command");
+}
+
+}
+
+int main() {
+    try {
+        tasks_compose();
+        async_mutex_excludes();
+        contended_lock_parks();
+        hub_async_flow();
+        std::cout << "async tests passed\n";
+        return 0;
+    } catch (const std::exception& ex) {
+        std::cerr << ex.what() << '\n';
+        return 1;
+    }
+}
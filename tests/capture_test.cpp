@@ -0,0 +1,78 @@
+#include "syncstream/capture.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+void need(bool ok, const std::string& msg) {
+    if (!ok) {
+        throw std::runtime_error(msg);
+    }
+}
+
+std::uint64_t fault_count(const syncstream::VerifyReport& r, syncstream::Fault why) {
+    return r.by_fault[static_cast<std::size_t>(why)];
+}
+
+void verify_mixed_capture() {
+    const auto k1 = syncstream::mint_key();
+    const auto k2 = syncstream::mint_key();
+    syncstream::RelayCore v1(k1, std::chrono::seconds(5));
+    syncstream::RelayCore v2(k2, std::chrono::seconds(5), 64, syncstream::default_clock(), syncstream::Suite::chacha_poly);
+    const std::uint64_t t0 = 1'700'000'000'000ULL;
+
+    std::vector<std::uint8_t> cap;
+    std::vector<syncstream::CaptureRecord> recs;
+    for (int i = 0; i < 3000; ++i) {
+        auto& core = i % 2 == 0 ? v1 : v2;
+        const auto at = t0 + static_cast<std::uint64_t>(i);
+        syncstream::Ctrl c{"cam-" + std::to_string(i % 40), syncstream::Cmd::ping, at, {}};
+        recs.push_back({at + 20, {i % 2 == 0 ? 1U : 2U, core.seal_ctrl(c)}});
+    }
+    recs[100].env.env.pkt.body[0] ^= 0x01U;
+    recs[200].recv_ms += 60'000;
+    recs[300].env.key_ver = 9;
+    recs.push_back(recs[400]);
+    recs.push_back(recs[401]);
+    for (const auto& r : recs) {
+        syncstream::append_record(cap, r);
+    }
+    cap.resize(cap.size() + 7, 0xEE);
+
+    const std::vector<syncstream::VerifyKey> keys{{1, k1, syncstream::Suite::aes_gcm}, {2, k2, syncstream::Suite::chacha_poly}};
+    const auto serial = syncstream::verify_capture(cap, keys, std::chrono::seconds(5), 1);
+    const auto wide = syncstream::verify_capture(cap, keys, std::chrono::seconds(5), 8);
+
+    for (const auto* r : {&serial, &wide}) {
+        need(r->total == 3003 && r->ok == 2997, "verify totals wrong");
+        need(fault_count(*r, syncstream::Fault::auth) == 1, "tamper not caught");
+        need(fault_count(*r, syncstream::Fault::skew) == 1, "skew not caught");
+        need(fault_count(*r, syncstream::Fault::unknown_key) == 1, "unknown key not caught");
+        need(fault_count(*r, syncstream::Fault::replay) == 2, "replay not caught");
+        need(fault_count(*r, syncstream::Fault::malformed) == 1, "trailing bytes not caught");
+    }
+    need(wide.faults.size() == serial.faults.size(), "parallel faults differ");
+    for (std::size_t i = 0; i < wide.faults.size(); ++i) {
+        need(wide.faults[i].index == serial.faults[i].index && wide.faults[i].why == serial.faults[i].why, "parallel fault order differs");
+    }
+    need(serial.faults[0].index == 100 && serial.faults[0].why == syncstream::Fault::auth, "first fault wrong");
+    need(serial.faults[3].index == 3000 && serial.faults[3].why == syncstream::Fault::replay, "replay blamed on original");
+}
+
+}
+
+int main() {
+    try {
+        verify_mixed_capture();
+        std::cout << "capture tests passed\n";
+        return 0;
+    } catch (const std::exception& ex) {
+        std::cerr << ex.what() << '\n';
+        return 1;
+    }
+}
@@ -0,0 +1,143 @@
+#include "syncstream/clock_sync.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+void need(bool ok, const std::string& msg) {
+    if (!ok) {
+        throw std::runtime_error(msg);
+    }
+}
+
+std::string open_err(syncstream::RelayCore& rx, const syncstream::Env& env, std::uint64_t now) {
+    try {
+        static_cast<void>(rx.open_ctrl(env, now));
+    } catch (const std::exception& ex) {
+        return ex.what();
+    }
+    return "";
+}
+
+void sample_math() {
+    const auto s = syncstream::sample_of(1000, 6010, 6012, 1030);
+    need(s && s->offset_ms == 4996 && s->rtt_ms == 28, "ntp sample wrong");
+    const auto back = syncstream::sample_of(1000, 400, 402, 1010);
+    need(back && back->offset_ms == -604 && back->rtt_ms == 8, "negative offset wrong");
+    need(!syncstream::sample_of(1000, 10, 5, 1010), "reversed device stamps accepted");
+    need(!syncstream::sample_of(1000, 10, 50, 1010), "impossible rtt accepted");
+
+    const auto echo = syncstream::unpack_echo(syncstream::pack_echo({0x0102030405060708ULL, 42}).view());
+    need(echo && echo->probe_ms == 0x0102030405060708ULL && echo->recv_ms == 42, "echo roundtrip");
+    need(!syncstream::unpack_echo(syncstream::Body{}.view()), "empty body read as echo");
+}
+
+void filter_prefers_short_paths() {
+    syncstream::ClockTracker clocks(std::chrono::seconds(1), std::chrono::seconds(45));
+    need(clocks.add("cam", {5000, 80}, 0), "first sample");
+    need(clocks.add("cam", {5010, 20}, 1), "second sample");
+    need(clocks.add("cam", {4900, 300}, 2), "third sample");
+    need(!clocks.add("cam", {0, 5000}, 3), "slow sample kept");
+
+    const auto est = clocks.estimate("cam");
+    need(est && est->target_ms == 5010 && est->rtt_ms == 20 && est->samples == 3, "min delay not chosen");
+    need(est->offset_ms == 5000, "large offset not snapped");
+    need(est->jitter_ms >= 60 && est->jitter_ms <= 70, "jitter wrong");
+    need(est->margin_ms <= 1000, "margin above window");
+    need(!clocks.estimate("other"), "unknown device estimated");
+}
+
+void skewed_device_shrinks_window() {
+    const auto key = syncstream::mint_key();
+    const std::uint64_t base = 1'700'000'000'000ULL;
+    const std::uint64_t ahead = 20'000;
+    auto clocks = std::make_shared<syncstream::ClockTracker>(std::chrono::seconds(1), std::chrono::seconds(45));
+    syncstream::RelayCore cam(key, std::chrono::seconds(45));
+    syncstream::RelayCore relay(key, std::chrono::seconds(1));
+    relay.track_clocks(clocks);
+
+    syncstream::Ctrl early{"cam-9", syncstream::Cmd::sync, base + ahead, {1}};
+    need(open_err(relay, cam.seal_ctrl(early), base) == "timestamp skew", "untracked skew accepted");
+
+    const syncstream::Ctrl probe{"cam-9", syncstream::Cmd::ping, base, {}};
+    const auto echo = cam.seal_ctrl(syncstream::answer_probe(probe, base + ahead + 10, base + ahead + 12));
+    need(open_err(relay, echo, base + 25).empty(), "echo rejected");
+    need(open_err(relay, echo, base + 26) == "replay blocked", "echo replay accepted");
+    const auto est = clocks->estimate("cam-9");
+    need(est && est->offset_ms == 19998 && est->rtt_ms == 23, "offset not learned");
+
+    syncstream::Ctrl sync{"cam-9", syncstream::Cmd::sync, base + ahead + 500, {2}};
+    const auto env = cam.seal_ctrl(sync);
+    need(open_err(relay, env, base + 520).empty(), "corrected sync rejected");
+    need(open_err(relay, env, base + 530) == "replay blocked", "sync replay accepted");
+
+    sync.at_ms = base + ahead + 500 - 900;
+    need(open_err(relay, cam.seal_ctrl(sync), base + 540) == "timestamp skew", "stale sync inside raw window accepted");
+    need(open_err(relay, echo, base + 5000) == "probe expired", "stale probe accepted");
+}
+
+void slew_is_bounded() {
+    syncstream::ClockTracker clocks(std::chrono::seconds(1), std::chrono::seconds(45));
+    need(clocks.add("cam", {600, 10}, 0), "first sample");
+    need(clocks.estimate("cam")->offset_ms == 250, "first step not bounded");
+    need(clocks.add("cam", {600, 10}, 1000), "held sample");
+    need(clocks.estimate("cam")->offset_ms == 250, "step before hold");
+    need(clocks.add("cam", {600, 10}, 2500), "second step");
+    need(clocks.estimate("cam")->offset_ms == 500, "second step wrong");
+    need(clocks.add("cam", {600, 10}, 5000), "third step");
+    const auto est = clocks.estimate("cam");
+    need(est->offset_ms == 600 && est->margin_ms < 1000, "slew did not converge");
+
+    const auto admitted = clocks.admit("cam", syncstream::Cmd::sync, {}, 10'600, 10'000);
+    need(admitted == 10'000, "admit did not correct");
+    bool hit = false;
+    try {
+        static_cast<void>(clocks.admit("cam", syncstream::Cmd::sync, {}, 10'000, 10'000));
+    } catch (const std::exception&) {
+        hit = true;
+    }
+    need(hit, "uncorrected stamp admitted");
+}
+
+void replay_survives_one_step() {
+    syncstream::ReplayWheel wheel(std::chrono::seconds(1), 64);
+    syncstream::ReplayKey key{};
+    key.raw[0] = 7;
+    need(!wheel.seen_or_mark(key, 10'000, 10'000), "fresh key seen");
+    need(wheel.seen_or_mark(key, 10'250, 10'100), "key missed one epoch later");
+    need(wheel.seen_or_mark(key, 9'750, 10'100), "key missed one epoch earlier");
+}
+
+void window_must_fit_skew() {
+    syncstream::RelayCore relay(syncstream::mint_key(), std::chrono::milliseconds(500));
+    bool hit = false;
+    try {
+        relay.track_clocks(std::make_shared<syncstream::ClockTracker>(std::chrono::seconds(1), std::chrono::seconds(45)));
+    } catch (const std::exception&) {
+        hit = true;
+    }
+    need(hit, "wide clock window accepted");
+}
+
+}
+
+int main() {
+    try {
+        sample_math();
+        filter_prefers_short_paths();
+        skewed_device_shrinks_window();
+        slew_is_bounded();
+        replay_survives_one_step();
+        window_must_fit_skew();
+        std::cout << "clock sync tests passed\n";
+        return 0;
+    } catch (const std::exception& ex) {
+        std::cerr << ex.what() << '\n';
+        return 1;
+    }
+}
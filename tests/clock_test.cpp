@@ -0,0 +1,70 @@
+#include "syncstream/clock.hpp"
+#include "syncstream/middleware.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+namespace {
+
+void need(bool ok, const std::string& msg) {
+    if (!ok) {
+        throw std::runtime_error(msg);
+    }
+}
+
+bool near_wall(const syncstream::Clock& clock) {
+    const auto a = clock.now_ms();
+    const auto b = syncstream::now_ms();
+    const auto gap = a > b ? a - b : b - a;
+    return gap < 1000;
+}
+
+void sources_track_wall() {
+    syncstream::WallClock wall;
+    syncstream::CoarseClock coarse;
+    syncstream::MonoClock mono;
+    syncstream::TickClock tick(std::chrono::milliseconds(2));
+    need(near_wall(wall), "wall clock off");
+    need(near_wall(coarse), "coarse clock off");
+    need(near_wall(mono), "mono clock off");
+    need(near_wall(tick), "tick clock off");
+
+    const auto first = tick.now_ms();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    need(tick.now_ms() > first, "tick clock not advancing");
+
+    const auto m1 = mono.now_ms();
+    mono.resync();
+    need(mono.now_ms() + 5 >= m1, "mono clock stepped backwards");
+
+    const auto def = syncstream::default_clock();
+    need(near_wall(*def), "default clock off");
+    need(dynamic_cast<const syncstream::MonoClock*>(def.get()) != nullptr, "default clock not monotonic");
+}
+
+void manual_is_deterministic() {
+    syncstream::ManualClock clock(100);
+    need(clock.now_ms() == 100, "manual start wrong");
+    clock.advance(std::chrono::milliseconds(25));
+    need(clock.now_ms() == 125, "manual advance wrong");
+    clock.set(7);
+    need(clock.now_ms() == 7, "manual set wrong");
+}
+
+}
+
+int main() {
+    try {
+        sources_track_wall();
+        manual_is_deterministic();
+        std::cout << "clock tests passed\n";
+        return 0;
+    } catch (const std::exception& ex) {
+        std::cerr << ex.what() << '\n';
+        return 1;
+    }
+}
@@ -0,0 +1,179 @@
+#include "syncstream/codec.hpp"
+#include "syncstream/secure_channel.hpp"
+
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+void need(bool ok, const std::string& msg) {
+    if (!ok) {
+        throw std::runtime_error(msg);
+    }
+}
+
+std::vector<std::uint8_t> noise(std::size_t n, std::mt19937& gen) {
+    std::vector<std::uint8_t> out(n);
+    for (auto& b : out) {
+        b = static_cast<std::uint8_t>(gen());
+    }
+    return out;
+}
+
+std::string slow_hex(const std::vector<std::uint8_t>& data) {
+    static constexpr char lut[] = "0123456789abcdef";
+    std::string out;
+    for (const auto b : data) {
+        out.push_back(lut[b >> 4]);
+        out.push_back(lut[b & 0x0F]);
+    }
+    return out;
+}
+
+std::string slow_b64(const std::vector<std::uint8_t>& data) {
+    static constexpr char lut[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string out;
+    std::uint32_t acc = 0;
+    int bits = 0;
+    for (const auto b : data) {
+        acc = (acc << 8) | b;
+        bits += 8;
+        while (bits >= 6) {
+            bits -= 6;
+            out.push_back(lut[(acc >> bits) & 0x3F]);
+        }
+    }
+    if (bits > 0) {
+        out.push_back(lut[(acc << (6 - bits)) & 0x3F]);
+    }
+    while (out.size() % 4 != 0) {
+        out.push_back('=');
+    }
+    return out;
+}
+
+bool throws(const std::string& text, bool b64) {
+    bool hit = false;
+    try {
+        if (b64) {
+            static_cast<void>(syncstream::from_b64(text));
+        } else {
+            static_cast<void>(syncstream::from_hex(text));
+        }
+    } catch (const std::exception&) {
+        hit = true;
+    }
+    return hit;
+}
+
+void hex_matches_reference() {
+    std::mt19937 gen(7);
+    for (std::size_t n = 0; n < 200; ++n) {
+        const auto data = noise(n, gen);
+        const auto text = syncstream::hex_of(data);
+        need(text == slow_hex(data), "hex encode mismatch");
+        need(syncstream::from_hex(text) == data, "hex decode mismatch");
+    }
+    const auto big = noise(1 << 16, gen);
+    need(syncstream::from_hex(syncstream::hex_of(big)) == big, "large hex mismatch");
+
+    auto upper = syncstream::hex_of(big);
+    for (auto& c : upper) {
+        if (c >= 'a') {
+            c = static_cast<char>(c - 'a' + 'A');
+        }
+    }
+    need(syncstream::from_hex(upper) == big, "upper hex rejected");
+}
+
+void hex_rejects_bad_chars() {
+    const auto text = std::string(96, 'a');
+    for (std::size_t i = 0; i < text.size(); ++i) {
+        for (const char c : {'g', 'G', '/', ':', '@', '`', ' ', '\0', '\xff'}) {
+            auto bad = text;
+            bad[i] = c;
+            need(throws(bad, false), "bad hex accepted");
+        }
+    }
+    need(throws("abc", false), "odd hex accepted");
+}
+
+void b64_matches_reference() {
+    need(syncstream::b64_of(std::vector<std::uint8_t>{}).empty(), "empty b64");
+    const std::vector<std::pair<std::string, std::string>> vecs = {{"f", "Zg=="}, {"fo", "Zm8="}, {"foo", "Zm9v"}, {"foob", "Zm9vYg=="}, {"fooba", "Zm9vYmE="}, {"foobar", "Zm9vYmFy"}};
+    for (const auto& [plain, enc] : vecs) {
+        const std::vector<std::uint8_t> raw(plain.begin(), plain.end());
+        need(syncstream::b64_of(raw) == enc, "rfc vector encode");
+        need(syncstream::from_b64(enc) == raw, "rfc vector decode");
+    }
+
+    std::mt19937 gen(11);
+    for (std::size_t n = 0; n < 200; ++n) {
+        const auto data = noise(n, gen);
+        const auto text = syncstream::b64_of(data);
+        need(text == slow_b64(data), "b64 encode mismatch");
+        need(syncstream::from_b64(text) == data, "b64 decode mismatch");
+    }
+    const auto big = noise((1 << 16) + 1, gen);
+    need(syncstream::from_b64(syncstream::b64_of(big)) == big, "large b64 mismatch");
+}
+
+void b64_is_strict() {
+    need(throws("Zg=", true), "short b64 accepted");
+    need(throws("Zh==", true), "padding bits accepted");
+    need(throws("Zm9=", true), "padding bits accepted");
+    need(throws("Z===", true), "triple pad accepted");
+    need(throws("Zg==Zg==", true), "inner padding accepted");
+    need(throws("Zm=v", true), "mid padding accepted");
+
+    const auto text = slow_b64(std::vector<std::uint8_t>(96, 0x5A));
+    for (std::size_t i = 0; i < text.size(); ++i) {
+        for (const char c : {'-', '_', '.', '=', ' ', '\0', '\x80'}) {
+            auto bad = text;
+            bad[i] = c;
+            need(throws(bad, true), "bad b64 accepted");
+        }
+    }
+}
+
+void small_buffers_refused() {
+    const std::vector<std::uint8_t> data(10, 1);
+    std::vector<char> out(19);
+    bool hit = false;
+    try {
+        static_cast<void>(syncstream::hex_encode(data, out));
+    } catch (const std::exception&) {
+        hit = true;
+    }
+    need(hit, "short hex buffer accepted");
+
+    std::vector<std::uint8_t> raw(2);
+    hit = false;
+    try {
+        static_cast<void>(syncstream::b64_decode("Zm9v", raw));
+    } catch (const std::exception&) {
+        hit = true;
+    }
+    need(hit, "short b64 buffer accepted");
+}
+
+}
+
+int main() {
+    try {
+        hex_matches_reference();
+        hex_rejects_bad_chars();
+        b64_matches_reference();
+        b64_is_strict();
+        small_buffers_refused();
+        std::cout << "codec tests passed (" << syncstream::codec_path() << ")\n";
+        return 0;
+    } catch (const std::exception& ex) {
+        std::cerr << ex.what() << '\n';
+        return 1;
+    }
+}
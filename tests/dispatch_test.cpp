@@ -0,0 +1,94 @@
+#include "syncstream/dispatch.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+void need(bool ok, const std::string& msg) {
+    if (!ok) {
+        throw std::runtime_error(msg);
+    }
+}
+
+syncstream::Ctrl make(syncstream::Cmd cmd, std::uint64_t at) {
+    return syncstream::Ctrl{"cam-q", cmd, at, {}};
+}
+
+void strict_order() {
+    syncstream::Dispatcher disp;
+    need(disp.push(make(syncstream::Cmd::ping, 0), 0) == syncstream::Shed::none, "ping refused");
+    need(disp.push(make(syncstream::Cmd::sync, 0), 0) == syncstream::Shed::none, "sync refused");
+    need(disp.push(make(syncstream::Cmd::disarm, 0), 0) == syncstream::Shed::none, "disarm refused");
+
+    need(disp.pop(1)->cmd == syncstream::Cmd::disarm, "critical not first");
+    need(disp.pop(1)->cmd == syncstream::Cmd::sync, "normal not second");
+    need(disp.pop(1)->cmd == syncstream::Cmd::ping, "bulk not last");
+    need(!disp.pop(1).has_value(), "queue not empty");
+}
+
+void sheds_bulk_under_delay() {
+    syncstream::DispatchConfig cfg;
+    cfg.depth = 64;
+    syncstream::Dispatcher disp(cfg);
+    for (int i = 0; i < 64; ++i) {
+        static_cast<void>(disp.push(make(syncstream::Cmd::ping, 0), 0));
+    }
+    need(disp.push(make(syncstream::Cmd::ping, 0), 0) == syncstream::Shed::queue_full, "depth not enforced");
+
+    need(disp.pop(200).has_value(), "first pop empty");
+    need(disp.pop(310).has_value(), "codel dropped everything");
+    need(disp.dropping(syncstream::Prio::bulk), "bulk lane not in dropping state");
+    need(disp.stats(syncstream::Prio::bulk).shed_stale == 1, "stale head not shed");
+
+    need(disp.push(make(syncstream::Cmd::ping, 310), 310) == syncstream::Shed::delay, "bulk admitted during overload");
+    need(disp.push(make(syncstream::Cmd::sync, 310), 310) == syncstream::Shed::none, "normal shed before bulk");
+    need(disp.push(make(syncstream::Cmd::arm, 310), 310) == syncstream::Shed::none, "critical shed");
+    const auto first = disp.pop(311);
+    need(first && first->cmd == syncstream::Cmd::arm, "critical delayed behind heartbeats");
+    need(disp.stats(syncstream::Prio::critical).max_wait_ms <= 1, "critical wait unbounded");
+
+    const auto st = disp.stats(syncstream::Prio::bulk);
+    need(st.shed_full == 1 && st.shed_delay == 1, "shed reasons not counted");
+    need(std::string(syncstream::shed_name(syncstream::Shed::delay)) == "queue delay", "shed name wrong");
+}
+
+void weighted_share() {
+    syncstream::DispatchConfig cfg;
+    cfg.strict = false;
+    cfg.weights = {1, 4, 1};
+    syncstream::Dispatcher disp(cfg);
+    for (int i = 0; i < 10; ++i) {
+        static_cast<void>(disp.push(make(syncstream::Cmd::sync, 0), 0));
+        static_cast<void>(disp.push(make(syncstream::Cmd::ping, 0), 0));
+    }
+    int syncs = 0;
+    int pings = 0;
+    for (int i = 0; i < 10; ++i) {
+        const auto out = disp.pop(1);
+        if (out->cmd == syncstream::Cmd::sync) {
+            ++syncs;
+        } else {
+            ++pings;
+        }
+    }
+    need(syncs == 8 && pings == 2, "weighted share wrong");
+}
+
+}
+
+int main() {
+    try {
+        strict_order();
+        sheds_bulk_under_delay();
+        weighted_share();
+        std::cout << "dispatch tests passed\n";
+        return 0;
+    } catch (const std::exception& ex) {
+        std::cerr << ex.what() << '\n';
+        return 1;
+    }
+}
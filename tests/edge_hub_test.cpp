@@ -3,6 +3,7 @@
 #include <chrono>
 #include <cstdint>
 #include <iostream>
+#include <memory>
 #include <stdexcept>
 #include <vector>
 
@@ -45,6 +46,126 @@ void rotate_and_open() {
     need(out2.body == ctrl.body, "second open failed");
 }
 
+void overlap_then_retire() {
+    const auto master = syncstream::mint_key();
+    syncstream::EdgeHub tx(master, std::chrono::seconds(30), 2048, 200, 200);
+    syncstream::EdgeHub warm(master, std::chrono::seconds(30), 2048, 200, 200, std::chrono::minutes(5));
+    syncstream::EdgeHub cold(master, std::chrono::seconds(30), 2048, 200, 200, std::chrono::milliseconds(0));
+
+    std::vector<std::uint8_t> s1{1, 1};
+    std::vector<std::uint8_t> c1{'v', '1'};
+    std::vector<std::uint8_t> s2{2, 2};
+    std::vector<std::uint8_t> c2{'v', '2'};
+    for (auto* hub : {&tx, &warm, &cold}) {
+        hub->allow_cmd(syncstream::Cmd::ping);
+        hub->stage_key(1, s1, c1, true);
+        hub->stage_key(2, s2, c2, false);
+    }
+    need(warm.live_versions() == 2, "staged core not prebuilt");
+
+    syncstream::Ctrl ctrl{"cam-rot", syncstream::Cmd::ping, syncstream::now_ms(), {1}};
+    const auto old_env = tx.seal(ctrl);
+    need(old_env.key_ver == 1, "staging changed active key");
+
+    warm.activate_key(2);
+    cold.activate_key(2);
+    need(cold.live_versions() == 1, "retired core not freed");
+    need(warm.retire_due() == 0, "overlap cut short");
+
+    need(warm.open(old_env).dev == ctrl.dev, "previous version rejected inside overlap");
+
+    bool hit = false;
+    try {
+        static_cast<void>(cold.open(old_env));
+    } catch (...) {
+        hit = true;
+    }
+    need(hit, "retired version still accepted");
+
+    tx.activate_key(2);
+    ctrl.at_ms = syncstream::now_ms();
+    const auto new_env = tx.seal(ctrl);
+    need(new_env.key_ver == 2, "rotation not active");
+    need(cold.open(new_env).dev == ctrl.dev, "active version rejected");
+}
+
+void restage_and_skipped_versions() {
+    const auto master = syncstream::mint_key();
+    auto clock = std::make_shared<syncstream::ManualClock>(1'700'000'000'000ULL);
+    syncstream::EdgeHub tx(master, std::chrono::seconds(30), 2048, 200, 200, std::chrono::seconds(10), clock);
+    syncstream::EdgeHub rx(master, std::chrono::seconds(30), 2048, 200, 200, std::chrono::seconds(10), clock);
+    std::vector<std::uint8_t> s1{1};
+    std::vector<std::uint8_t> c1{'r', '1'};
+    for (auto* hub : {&tx, &rx}) {
+        hub->allow_cmd(syncstream::Cmd::sync);
+        hub->stage_key(1, s1, c1, true);
+    }
+
+    const auto env = tx.seal({"cam-re", syncstream::Cmd::sync, clock->now_ms(), {1}});
+    need(rx.open(env).dev == syncstream::DevId("cam-re"), "first open failed");
+    bool hit = false;
+    try {
+        rx.stage_key(1, s1, c1, false);
+    } catch (const std::exception&) {
+        hit = true;
+    }
+    need(hit, "live version re-staged");
+    hit = false;
+    try {
+        static_cast<void>(rx.open(env));
+    } catch (const std::exception&) {
+        hit = true;
+    }
+    need(hit, "re-staging reopened replay window");
+
+    std::vector<std::uint8_t> s2{2};
+    std::vector<std::uint8_t> s3{3};
+    rx.stage_key(2, s2, c1, false);
+    rx.stage_key(3, s3, c1, false);
+    rx.stage_key(4, s3, s2, false);
+    rx.activate_key(3);
+    need(rx.live_versions() == 4, "overlap dropped early");
+    clock->advance(std::chrono::seconds(10));
+    need(rx.retire_due() == 2 && rx.live_versions() == 2, "skipped version never retired");
+
+    hit = false;
+    try {
+        rx.stage_key(5, s2, s2, false, static_cast<syncstream::Suite>(9));
+    } catch (const std::exception&) {
+        hit = true;
+    }
+    need(hit && rx.live_versions() == 2, "failed build left a staged core");
+    rx.stage_key(5, s2, s2, false);
+    need(rx.live_versions() == 3, "retry after failed build refused");
+}
+
+void suite_per_version() {
+    const auto master = syncstream::mint_key();
+    syncstream::EdgeHub tx(master, std::chrono::seconds(30), 2048, 200, 200);
+    syncstream::EdgeHub rx(master, std::chrono::seconds(30), 2048, 200, 200);
+    std::vector<std::uint8_t> s{3};
+    std::vector<std::uint8_t> c{'c', 'h'};
+    tx.stage_key(4, s, c, true, syncstream::Suite::chacha_poly);
+    rx.stage_key(4, s, c, true, syncstream::Suite::chacha_poly);
+    tx.allow_cmd(syncstream::Cmd::arm);
+    rx.allow_cmd(syncstream::Cmd::arm);
+
+    syncstream::Ctrl ctrl{"cam-arm", syncstream::Cmd::arm, syncstream::now_ms(), {1}};
+    auto env = tx.seal(ctrl);
+    need(env.env.pkt.suite == syncstream::Suite::chacha_poly, "version suite not used");
+    need(rx.open(env).dev == ctrl.dev, "chacha version open failed");
+
+    env = tx.seal(ctrl);
+    env.env.pkt.suite = syncstream::Suite::aes_gcm;
+    bool hit = false;
+    try {
+        static_cast<void>(rx.open(env));
+    } catch (...) {
+        hit = true;
+    }
+    need(hit, "suite downgrade accepted");
+}
+
 void policy_block() {
     const auto master = syncstream::mint_key();
     syncstream::EdgeHub tx(master, std::chrono::seconds(30), 2048, 200, 200);
@@ -83,13 +204,130 @@ void rate_block() {
     need(hit, "rate limit not enforced");
 }
 
+void rate_refill_manual_clock() {
+    const auto master = syncstream::mint_key();
+    auto clock = std::make_shared<syncstream::ManualClock>(1'700'000'000'000ULL);
+    syncstream::EdgeHub tx(master, std::chrono::seconds(30), 2048, 2, 1, std::chrono::seconds(30), clock);
+    std::vector<std::uint8_t> s{1};
+    std::vector<std::uint8_t> c{2};
+    tx.stage_key(1, s, c, true);
+    tx.allow_cmd(syncstream::Cmd::ping);
+
+    syncstream::Ctrl ctrl{"cam-tick", syncstream::Cmd::ping, clock->now_ms(), {}};
+    static_cast<void>(tx.seal(ctrl));
+    static_cast<void>(tx.seal(ctrl));
+    bool hit = false;
+    try {
+        static_cast<void>(tx.seal(ctrl));
+    } catch (...) {
+        hit = true;
+    }
+    need(hit, "burst not enforced");
+
+    clock->advance(std::chrono::milliseconds(1000));
+    static_cast<void>(tx.seal(ctrl));
+}
+
+void coalesce_bursts() {
+    const auto master = syncstream::mint_key();
+    auto clock = std::make_shared<syncstream::ManualClock>(1'700'000'000'000ULL);
+    syncstream::EdgeHub tx(master, std::chrono::seconds(30), 2048, 200, 200, std::chrono::seconds(30), clock);
+    syncstream::EdgeHub rx(master, std::chrono::seconds(30), 2048, 200, 200, std::chrono::seconds(30), clock);
+    std::vector<std::uint8_t> s{1};
+    std::vector<std::uint8_t> c{2};
+    for (auto* hub : {&tx, &rx}) {
+        hub->stage_key(1, s, c, true);
+        hub->allow_cmd(syncstream::Cmd::sync);
+        hub->allow_cmd(syncstream::Cmd::ping);
+        hub->allow_cmd(syncstream::Cmd::arm);
+    }
+    rx.coalesce(std::chrono::milliseconds(50));
+
+    const auto at = clock->now_ms();
+    rx.submit(tx.seal({"cam-c", syncstream::Cmd::sync, at, {'7', '2', '0'}}));
+    rx.submit(tx.seal({"cam-c", syncstream::Cmd::ping, at, {}}));
+    rx.submit(tx.seal({"cam-c", syncstream::Cmd::sync, at, {'1', '0', '8', '0'}}));
+    rx.submit(tx.seal({"cam-c", syncstream::Cmd::ping, at, {}}));
+    rx.submit(tx.seal({"cam-d", syncstream::Cmd::sync, at, {'4', 'k'}}));
+    rx.submit(tx.seal({"cam-c", syncstream::Cmd::arm, at, {1}}));
+
+    auto out = rx.drain();
+    need(out.size() == 1 && out[0].cmd == syncstream::Cmd::arm, "critical command held back");
+
+    clock->advance(std::chrono::milliseconds(50));
+    out = rx.drain();
+    need(out.size() == 3, "coalesced output size wrong");
+    need(out[0].cmd == syncstream::Cmd::sync && out[0].body == syncstream::Body{'1', '0', '8', '0'}, "latest sync not kept");
+    need(out[1].cmd == syncstream::Cmd::ping && out[2].dev.str() == "cam-d", "coalesced order wrong");
+
+    const auto st = rx.coalesce_stats();
+    need(st.merged_sync == 1 && st.merged_ping == 1 && st.passed == 1 && st.held == 3, "coalesce counters wrong");
+
+    rx.submit(tx.seal({"cam-c", syncstream::Cmd::sync, clock->now_ms(), {'9'}}));
+    bool hit = false;
+    try {
+        rx.coalesce(std::chrono::milliseconds(10));
+    } catch (const std::exception&) {
+        hit = true;
+    }
+    need(hit, "reconfigure dropped pending commands");
+    clock->advance(std::chrono::milliseconds(50));
+    need(rx.drain().size() == 1, "pending command lost");
+    rx.coalesce(std::chrono::milliseconds(10));
+    need(rx.coalesce_stats().held == 0, "new coalescer kept old counters");
+}
+
+void beats_fan_out() {
+    const auto master = syncstream::mint_key();
+    auto clock = std::make_shared<syncstream::ManualClock>(1'700'000'000'000ULL);
+    syncstream::EdgeHub gw(master, std::chrono::seconds(5), 2048, 2, 1, std::chrono::seconds(30), clock);
+    syncstream::EdgeHub rx(master, std::chrono::seconds(5), 2048, 2, 1, std::chrono::seconds(30), clock);
+    std::vector<std::uint8_t> s{1};
+    std::vector<std::uint8_t> c{2};
+    for (auto* hub : {&gw, &rx}) {
+        hub->stage_key(1, s, c, true);
+        hub->allow_cmd(syncstream::Cmd::beats);
+    }
+    rx.track_presence(std::make_shared<syncstream::PresenceTable>(1024, std::chrono::seconds(30)));
+
+    const auto at = clock->now_ms();
+    syncstream::BeatBatch batch("gw-lobby", 512);
+    for (int i = 0; i < 300; ++i) {
+        need(!batch.add("cam-" + std::to_string(i), at - 100), "batch full early");
+    }
+    need(!batch.add("cam-7", at), "duplicate beat grew batch");
+    need(!batch.add("cam-stale", at - 60'000), "stale beat refused by batch");
+    need(batch.size() == 301, "batch dedupe wrong");
+
+    const auto out = rx.open(gw.seal(batch.take(at)));
+    need(out.cmd == syncstream::Cmd::beats && batch.size() == 0, "batch not taken");
+    need(rx.last_seen("cam-7") == at && rx.last_seen("cam-299") == at - 100, "beat not fanned out");
+    need(!rx.last_seen("cam-stale"), "beat outside skew applied");
+    need(!rx.last_seen("gw-lobby"), "gateway marked as device");
+
+    auto body = gw.seal({"gw-lobby", syncstream::Cmd::beats, at, {0, 2, 0, 1}});
+    bool hit = false;
+    try {
+        static_cast<void>(rx.open(body));
+    } catch (...) {
+        hit = true;
+    }
+    need(hit, "truncated beat batch accepted");
+}
+
 }
 
 int main() {
     try {
         rotate_and_open();
+        overlap_then_retire();
+        restage_and_skipped_versions();
+        suite_per_version();
         policy_block();
         rate_block();
+        rate_refill_manual_clock();
+        coalesce_bursts();
+        beats_fan_out();
         std::cout << "edge hub tests passed\n";
         return 0;
     } catch (const std::exception& ex) {
@@ -4,8 +4,11 @@
 #include <chrono>
 #include <cstdint>
 #include <iostream>
+#include <memory>
 #include <stdexcept>
 #include <string>
+#include <thread>
+#include <unordered_set>
 #include <vector>
 
 namespace {
@@ -34,6 +37,30 @@ void flow_ok() {
     need(out.body == c.body, "body mismatch");
 }
 
+void view_flow() {
+    const auto key = syncstream::mint_key();
+    syncstream::RelayCore tx(key, std::chrono::seconds(30));
+    syncstream::RelayCore rx(key, std::chrono::seconds(30));
+
+    syncstream::Ctrl c{"cam-view", syncstream::Cmd::ping, syncstream::now_ms(), {5, 6}};
+    need(c.dev.local() && c.body.local(), "short ctrl spilled to heap");
+    const auto view = rx.open_view(tx.seal_ctrl(c));
+    need(view.dev() == "cam-view", "view dev mismatch");
+    need(view.cmd() == c.cmd, "view cmd mismatch");
+    need(view.at_ms() == c.at_ms, "view time mismatch");
+    need(view.body().size() == 2 && view.body()[1] == 6, "view body mismatch");
+
+    syncstream::Ctrl big{};
+    big.dev = std::string(48, 'd');
+    big.cmd = syncstream::Cmd::sync;
+    big.at_ms = syncstream::now_ms();
+    big.body = std::vector<std::uint8_t>(300, 0x5A);
+    need(!big.dev.local() && !big.body.local(), "long ctrl kept inline");
+    const auto out = rx.open_ctrl(tx.seal_ctrl(big));
+    need(out.dev == big.dev, "long dev mismatch");
+    need(out.body == big.body, "long body mismatch");
+}
+
 void replay_blocked() {
     const auto key = syncstream::mint_key();
     syncstream::RelayCore tx(key, std::chrono::seconds(30));
@@ -69,13 +96,145 @@ void skew_blocked() {
     need(hit, "skew not blocked");
 }
 
+void skew_edges_manual_clock() {
+    const auto key = syncstream::mint_key();
+    const std::uint64_t t0 = 1'700'000'000'000ULL;
+    auto clock = std::make_shared<syncstream::ManualClock>(t0);
+    syncstream::RelayCore tx(key, std::chrono::seconds(5), 64, clock);
+    syncstream::RelayCore rx(key, std::chrono::seconds(5), 64, clock);
+
+    syncstream::Ctrl c{"cam-clock", syncstream::Cmd::ping, t0 - 5000, {}};
+    need(rx.open_ctrl(tx.seal_ctrl(c)).at_ms == t0 - 5000, "edge of window rejected");
+
+    c.at_ms = t0 + 5000;
+    const auto ahead = tx.seal_ctrl(c);
+    clock->advance(std::chrono::milliseconds(10'001));
+    bool hit = false;
+    try {
+        static_cast<void>(rx.open_ctrl(ahead));
+    } catch (...) {
+        hit = true;
+    }
+    need(hit, "stale envelope accepted after clock advance");
+}
+
+void replay_expires_by_age() {
+    const auto key = syncstream::mint_key();
+    const std::uint64_t t0 = 1'700'000'000'000ULL;
+    auto clock = std::make_shared<syncstream::ManualClock>(t0);
+    syncstream::RelayCore tx(key, std::chrono::seconds(4), 8, clock);
+    syncstream::RelayCore rx(key, std::chrono::seconds(4), 8, clock);
+
+    syncstream::Ctrl c{"cam-wheel", syncstream::Cmd::ping, t0, {}};
+    const auto first = tx.seal_ctrl(c);
+    static_cast<void>(rx.open_ctrl(first));
+    for (int i = 0; i < 100; ++i) {
+        static_cast<void>(rx.open_ctrl(tx.seal_ctrl(c)));
+    }
+    need(rx.replay_size() == 101, "replay entries lost under burst");
+
+    clock->advance(std::chrono::milliseconds(3000));
+    bool hit = false;
+    try {
+        static_cast<void>(rx.open_ctrl(first));
+    } catch (...) {
+        hit = true;
+    }
+    need(hit, "replay accepted after count overflow");
+
+    clock->advance(std::chrono::milliseconds(2000));
+    c.at_ms = clock->now_ms();
+    static_cast<void>(rx.open_ctrl(tx.seal_ctrl(c)));
+    need(rx.replay_size() == 1, "expired bucket not dropped");
+}
+
+void clock_steps_back() {
+    const auto key = syncstream::mint_key();
+    const std::uint64_t t0 = 1'700'000'000'000ULL;
+    auto clock = std::make_shared<syncstream::ManualClock>(t0);
+    syncstream::RelayCore tx(key, std::chrono::seconds(4), 64, clock);
+    syncstream::RelayCore rx(key, std::chrono::seconds(4), 64, clock);
+
+    for (std::uint64_t k = 0; k <= 8; ++k) {
+        static_cast<void>(rx.open_ctrl(tx.seal_ctrl({"cam-step", syncstream::Cmd::ping, t0 - 4000 + k * 1000, {}})));
+    }
+    clock->set(t0 - 3'600'000);
+    const auto back = clock->now_ms();
+    std::vector<syncstream::Env> sent;
+    for (std::uint64_t k = 0; k <= 8; ++k) {
+        sent.push_back(tx.seal_ctrl({"cam-step", syncstream::Cmd::ping, back - 4000 + k * 1000, {}}));
+        static_cast<void>(rx.open_ctrl(sent.back()));
+    }
+    bool hit = false;
+    try {
+        static_cast<void>(rx.open_ctrl(sent[4]));
+    } catch (...) {
+        hit = true;
+    }
+    need(hit, "replay accepted after clock step");
+}
+
+void concurrent_seal() {
+    const auto key = syncstream::mint_key();
+    syncstream::RelayCore tx(key, std::chrono::seconds(30));
+    syncstream::RelayCore rx(key, std::chrono::seconds(30), 8192);
+
+    constexpr int threads = 8;
+    constexpr int per = 250;
+    std::vector<std::vector<syncstream::Env>> out(threads);
+    {
+        std::vector<std::jthread> pool;
+        for (int t = 0; t < threads; ++t) {
+            pool.emplace_back([&, t] {
+                for (int i = 0; i < per; ++i) {
+                    out[static_cast<std::size_t>(t)].push_back(tx.seal_ctrl({"cam-par", syncstream::Cmd::ping, syncstream::now_ms(), {}}));
+                }
+            });
+        }
+    }
+
+    std::unordered_set<std::uint64_t> seqs;
+    for (const auto& batch : out) {
+        for (const auto& env : batch) {
+            need(seqs.insert(env.seq).second, "sequence reused across threads");
+            static_cast<void>(rx.open_ctrl(env));
+        }
+    }
+    need(seqs.size() == threads * per, "sequence count wrong");
+}
+
+void forgery_does_not_poison_replay() {
+    const auto key = syncstream::mint_key();
+    syncstream::RelayCore tx(key, std::chrono::seconds(30));
+    syncstream::RelayCore rx(key, std::chrono::seconds(30));
+
+    const auto env = tx.seal_ctrl({"cam-race", syncstream::Cmd::arm, syncstream::now_ms(), {1}});
+    auto forged = env;
+    forged.pkt.body[0] ^= 0x01U;
+    bool hit = false;
+    try {
+        static_cast<void>(rx.open_ctrl(forged));
+    } catch (...) {
+        hit = true;
+    }
+    need(hit, "forged envelope accepted");
+    need(rx.replay_size() == 0, "forged envelope marked in replay cache");
+    need(rx.open_ctrl(env).dev.str() == "cam-race", "genuine envelope blocked by forgery");
+}
+
 }
 
 int main() {
     try {
         flow_ok();
+        view_flow();
         replay_blocked();
         skew_blocked();
+        skew_edges_manual_clock();
+        replay_expires_by_age();
+        clock_steps_back();
+        concurrent_seal();
+        forgery_does_not_poison_replay();
         std::cout << "middleware tests passed\n";
         return 0;
     } catch (const std::exception& ex) {
@@ -0,0 +1,173 @@
+#include "syncstream/edge_hub.hpp"
+#include "syncstream/presence.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+void need(bool ok, const std::string& msg) {
+    if (!ok) {
+        throw std::runtime_error(msg);
+    }
+}
+
+struct Event {
+    std::string dev;
+    syncstream::Presence state;
+    std::uint64_t at_ms;
+};
+
+void online_then_offline() {
+    syncstream::PresenceTable table(16, std::chrono::seconds(5));
+    std::vector<Event> events;
+    table.subscribe([&](std::string_view dev, syncstream::Presence state, std::uint64_t at_ms) { events.push_back({std::string(dev), state, at_ms}); });
+
+    const std::uint64_t t0 = 1'700'000'000'000ULL;
+    need(table.state("cam-a") == syncstream::Presence::unknown, "unseen device has state");
+    need(table.seen("cam-a", t0), "first ping dropped");
+    need(table.state("cam-a") == syncstream::Presence::online && table.online() == 1, "ping did not bring device online");
+    need(events.size() == 1 && events[0].state == syncstream::Presence::online && events[0].at_ms == t0, "online not published");
+    need(table.seen("cam-a", t0 + 1000) && events.size() == 1, "repeat ping republished");
+
+    need(table.advance(t0 + 5500) == 0, "fresh ping expired");
+    need(table.state("cam-a") == syncstream::Presence::online, "lazy requeue lost device");
+    need(table.advance(t0 + 6000) == 1, "offline not fired at timeout");
+    need(table.state("cam-a") == syncstream::Presence::offline && table.online() == 0, "device still online");
+    need(events.size() == 2 && events[1].state == syncstream::Presence::offline && events[1].at_ms == t0 + 6000, "offline not published");
+    need(table.last_seen("cam-a") == t0 + 1000, "last seen wrong");
+
+    need(table.seen("cam-a", t0 + 9000), "return ping dropped");
+    need(events.size() == 3 && events[2].state == syncstream::Presence::online, "return not published");
+    need(table.advance(t0 + 13900) == 0, "returned device expired early");
+    need(table.advance(t0 + 14000) == 1, "returned device never expired");
+}
+
+void long_timeout_cascades() {
+    syncstream::PresenceTable table(8, std::chrono::hours(2), std::chrono::milliseconds(10));
+    const std::uint64_t t0 = 50'000;
+    need(table.seen("cam-slow", t0), "ping dropped");
+    const auto hold = static_cast<std::uint64_t>(std::chrono::milliseconds(std::chrono::hours(2)).count());
+    need(table.advance(t0 + hold - 10) == 0, "cascaded timer fired early");
+    need(table.state("cam-slow") == syncstream::Presence::online, "device dropped before timeout");
+    need(table.advance(t0 + hold) == 1, "cascaded timer lost");
+}
+
+void many_devices_expire_together() {
+    const std::size_t count = 200'000;
+    syncstream::PresenceTable table(count, std::chrono::seconds(30));
+    std::size_t offline = 0;
+    table.subscribe([&](std::string_view, syncstream::Presence state, std::uint64_t) {
+        if (state == syncstream::Presence::offline) {
+            ++offline;
+        }
+    });
+    for (std::size_t i = 0; i < count; ++i) {
+        need(table.seen("cam-" + std::to_string(i), 1000 + (i % 1000)), "enroll failed");
+    }
+    need(table.size() == count && table.online() == count, "table not full");
+    need(!table.seen("cam-extra", 2000), "table grew past capacity");
+    need(table.state("cam-extra") == syncstream::Presence::unknown, "overflow device tracked");
+
+    for (std::size_t i = 0; i < count; i += 2) {
+        need(table.seen("cam-" + std::to_string(i), 20'000), "refresh failed");
+    }
+    need(table.advance(32'000) == count / 2, "stale half not expired");
+    need(offline == count / 2 && table.online() == count / 2, "offline count wrong");
+    const auto idx = table.index_of("cam-7");
+    need(idx && table.name_at(*idx) == "cam-7" && table.state_at(*idx) == syncstream::Presence::offline, "dense lookup wrong");
+    need(table.advance(50'000) == count / 2, "refreshed half not expired");
+    need(table.online() == 0, "devices left online");
+}
+
+void bad_timing_rejected() {
+    bool hit = false;
+    try {
+        syncstream::PresenceTable table(8, std::chrono::milliseconds(50), std::chrono::milliseconds(100));
+    } catch (const std::exception&) {
+        hit = true;
+    }
+    need(hit, "tick longer than timeout accepted");
+}
+
+void notifications_follow_state() {
+    syncstream::PresenceTable table(8, std::chrono::milliseconds(20), std::chrono::milliseconds(1));
+    std::unordered_map<std::string, syncstream::Presence> last;
+    std::size_t calls = 0;
+    table.subscribe([&](std::string_view dev, syncstream::Presence state, std::uint64_t) {
+        last[std::string(dev)] = state;
+        ++calls;
+    });
+
+    std::atomic<std::uint64_t> now{1'000};
+    std::atomic<bool> stop{false};
+    std::thread ticker([&] {
+        while (!stop.load()) {
+            static_cast<void>(table.advance(now.fetch_add(3)));
+        }
+    });
+    std::atomic<std::size_t> late{0};
+    for (int i = 0; i < 20'000; ++i) {
+        static_cast<void>(table.seen("cam-" + std::to_string(i % 4), now.load()));
+        if (i % 5'000 == 0) {
+            table.subscribe([&](std::string_view, syncstream::Presence, std::uint64_t) { late.fetch_add(1); });
+        }
+    }
+    stop.store(true);
+    ticker.join();
+
+    need(calls > 0 && late.load() > 0, "no transitions published");
+    for (const auto& [dev, state] : last) {
+        need(table.state(dev) == state, "last callback disagrees with table");
+    }
+}
+
+void hub_feeds_presence() {
+    auto clock = std::make_shared<syncstream::ManualClock>(1'700'000'000'000ULL);
+    const auto master = syncstream::mint_key();
+    syncstream::EdgeHub tx(master, std::chrono::seconds(30), 2048, 200, 200, std::chrono::seconds(30), clock);
+    syncstream::EdgeHub rx(master, std::chrono::seconds(30), 2048, 200, 200, std::chrono::seconds(30), clock);
+    std::vector<std::uint8_t> salt{3, 1};
+    std::vector<std::uint8_t> ctx{'p', 'r'};
+    for (auto* hub : {&tx, &rx}) {
+        hub->stage_key(1, salt, ctx, true);
+        hub->allow_cmd(syncstream::Cmd::ping);
+        hub->allow_cmd(syncstream::Cmd::arm);
+    }
+    auto table = std::make_shared<syncstream::PresenceTable>(64, std::chrono::seconds(10));
+    rx.track_presence(table);
+
+    static_cast<void>(rx.open(tx.seal({"cam-arm", syncstream::Cmd::arm, clock->now_ms(), {0, 0, 0, 1}})));
+    need(table->state("cam-arm") == syncstream::Presence::unknown, "arm counted as liveness");
+
+    static_cast<void>(rx.open(tx.seal({"cam-p", syncstream::Cmd::ping, clock->now_ms(), {1}})));
+    need(table->state("cam-p") == syncstream::Presence::online, "ping not fed to presence");
+    clock->advance(std::chrono::seconds(11));
+    need(table->advance(clock->now_ms()) == 1, "hub device never expired");
+    need(table->state("cam-p") == syncstream::Presence::offline, "hub device still online");
+}
+
+}
+
+int main() {
+    try {
+        online_then_offline();
+        long_timeout_cascades();
+        many_devices_expire_together();
+        bad_timing_rejected();
+        notifications_follow_state();
+        hub_feeds_presence();
+        std::cout << "presence tests passed\n";
+        return 0;
+    } catch (const std::exception& ex) {
+        std::cerr << ex.what() << '\n';
+        return 1;
+    }
+}
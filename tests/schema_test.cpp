@@ -0,0 +1,144 @@
+#include "syncstream/schema.hpp"
+#include "syncstream/beats.hpp"
+#include "syncstream/clock_sync.hpp"
+#include "syncstream/sync_state.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr syncstream::SyncBody hd{syncstream::Res::p1080, 30, 4000, 60, false, true};
+
+static_assert(syncstream::wire_size_v<syncstream::SyncBody> == 10);
+static_assert(syncstream::wire_size_v<syncstream::ZoneBody> == 4);
+static_assert(syncstream::encode_body(hd)[0] == 3 && syncstream::encode_body(hd)[2] == 0);
+static_assert(syncstream::decode_body<syncstream::SyncBody>(syncstream::encode_body(hd)) == hd);
+static_assert(std::is_same_v<syncstream::body_t<syncstream::Cmd::disarm>, syncstream::ZoneBody>);
+static_assert(std::is_same_v<syncstream::body_t<syncstream::Cmd::ack>, syncstream::Ack>);
+static_assert(syncstream::wire_size_v<syncstream::Ack> == 28 && syncstream::wire_size_v<syncstream::Echo> == 16);
+
+void need(bool ok, const std::string& msg) {
+    if (!ok) {
+        throw std::runtime_error(msg);
+    }
+}
+
+void typed_roundtrip() {
+    const auto ctrl = syncstream::make_ctrl<syncstream::Cmd::sync>("cam-1", 5, hd);
+    need(ctrl.cmd == syncstream::Cmd::sync && ctrl.body.size() == 10, "typed ctrl wrong");
+    need(syncstream::body_as<syncstream::Cmd::sync>(ctrl) == hd, "typed body lost");
+
+    bool hit = false;
+    try {
+        static_cast<void>(syncstream::body_as<syncstream::Cmd::arm>(ctrl));
+    } catch (const std::exception&) {
+        hit = true;
+    }
+    need(hit, "wrong cmd decoded");
+}
+
+void decode_validates() {
+    auto raw = syncstream::encode_body(hd);
+    syncstream::SyncBody out{};
+    need(syncstream::try_decode_body(raw, out) && out == hd, "valid body refused");
+
+    auto bad = raw;
+    bad[8] = 2;
+    need(!syncstream::try_decode_body(bad, out), "non-boolean flag accepted");
+    bad = raw;
+    bad[0] = 9;
+    need(!syncstream::try_decode_body(bad, out), "unknown resolution accepted");
+    bad = raw;
+    bad[1] = 0;
+    need(!syncstream::try_decode_body(bad, out), "zero fps accepted");
+    need(!syncstream::try_decode_body(std::span<const std::uint8_t>(raw).first(9), out), "short body accepted");
+
+    need(syncstream::body_fits(syncstream::Cmd::sync, raw), "body_fits refused sync");
+    need(!syncstream::body_fits(syncstream::Cmd::arm, raw), "body_fits accepted sync as arm");
+    need(!syncstream::body_fits(syncstream::Cmd::ping, raw), "sync accepted as ping");
+    need(syncstream::body_fits(syncstream::Cmd::ping, {}), "empty ping refused");
+}
+
+void strict_core_rejects_untyped_bodies() {
+    const auto key = syncstream::mint_key();
+    syncstream::RelayCore tx(key, std::chrono::seconds(30));
+    syncstream::RelayCore loose(key, std::chrono::seconds(30));
+    syncstream::RelayCore strict(key, std::chrono::seconds(30));
+    strict.strict_bodies(true);
+
+    const auto now = syncstream::now_ms();
+    const auto good = tx.seal_ctrl(syncstream::make_ctrl<syncstream::Cmd::arm>("cam-2", now, {0x0F}));
+    need(syncstream::body_as<syncstream::Cmd::arm>(strict.open_view(good)).zones == 0x0F, "strict refused typed body");
+
+    const syncstream::Ctrl text{"cam-2", syncstream::Cmd::sync, now, std::vector<std::uint8_t>{'s', 't', 'a', 'r', 't'}};
+    const auto env = tx.seal_ctrl(text);
+    need(loose.open_ctrl(env).body == text.body, "loose core rejected free-form body");
+    bool hit = false;
+    try {
+        static_cast<void>(strict.open_ctrl(env));
+    } catch (const std::exception& ex) {
+        hit = std::string(ex.what()) == "body schema mismatch";
+    }
+    need(hit, "strict core accepted free-form body");
+}
+
+void strict_core_checks_every_cmd() {
+    const auto key = syncstream::mint_key();
+    syncstream::RelayCore tx(key, std::chrono::seconds(30));
+    syncstream::RelayCore strict(key, std::chrono::seconds(30));
+    strict.strict_bodies(true);
+    const auto now = syncstream::now_ms();
+
+    syncstream::BeatBatch batch("gw-1", 4);
+    static_cast<void>(batch.add("cam-a", now));
+    static_cast<void>(batch.add("cam-b", now));
+    syncstream::SyncSender sender;
+    const std::vector<syncstream::Ctrl> good{
+        {"cam-3", syncstream::Cmd::ping, now, {}},
+        syncstream::answer_probe({"cam-3", syncstream::Cmd::ping, now - 5, {}}, now - 2, now),
+        {"cam-3", syncstream::Cmd::ack, now, syncstream::pack_ack({1, 5, 9, 0x3})},
+        batch.take(now),
+        sender.stage("cam-3", hd, now).ctrl,
+    };
+    for (const auto& ctrl : good) {
+        need(strict.open_ctrl(tx.seal_ctrl(ctrl)).body == ctrl.body, "strict refused well-formed body");
+    }
+
+    const auto bad_ack = syncstream::encode_body(syncstream::Ack{1, 9, 5, 0});
+    const std::vector<syncstream::Ctrl> bad{
+        {"cam-3", syncstream::Cmd::ping, now, {1}},
+        {"cam-3", syncstream::Cmd::ack, now, std::span<const std::uint8_t>(bad_ack)},
+        {"cam-3", syncstream::Cmd::beats, now, std::vector<std::uint8_t>{0, 1, 0, 5, 'c'}},
+        {"cam-3", syncstream::Cmd::sync_delta, now, std::vector<std::uint8_t>{0, 0, 0, 1, 0, 0x01, 3}},
+    };
+    for (const auto& ctrl : bad) {
+        bool hit = false;
+        try {
+            static_cast<void>(strict.open_ctrl(tx.seal_ctrl(ctrl)));
+        } catch (const std::exception&) {
+            hit = true;
+        }
+        need(hit, "strict accepted malformed body");
+    }
+}
+
+}
+
+int main() {
+    try {
+        typed_roundtrip();
+        decode_validates();
+        strict_core_rejects_untyped_bodies();
+        strict_core_checks_every_cmd();
+        std::cout << "schema tests passed\n";
+        return 0;
+    } catch (const std::exception& ex) {
+        std::cerr << ex.what() << '\n';
+        return 1;
+    }
+}
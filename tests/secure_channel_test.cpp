@@ -86,6 +86,40 @@ void tamper_tag_fails() {
     need(hit, "tag tamper was not detected");
 }
 
+void chacha_roundtrip() {
+    const auto key = syncstream::mint_key();
+    syncstream::CipherRig rig(key, syncstream::Suite::chacha_poly);
+    syncstream::CipherRig gcm(key, syncstream::Suite::aes_gcm);
+    const auto aad = bytes_of("arm:cam-9");
+    const auto plain = bytes_of("low-end edge box");
+
+    syncstream::Packet p = rig.seal(plain, aad);
+    need(p.suite == syncstream::Suite::chacha_poly, "suite not carried");
+    const syncstream::SecureBlob out = rig.open(p, aad);
+    need(std::vector<std::uint8_t>(out.view().begin(), out.view().end()) == plain, "chacha roundtrip mismatch");
+
+    bool hit = false;
+    try {
+        static_cast<void>(gcm.open(p, aad));
+    } catch (...) {
+        hit = true;
+    }
+    need(hit, "suite mismatch was not detected");
+
+    p.mac[5] ^= 0x10U;
+    hit = false;
+    try {
+        static_cast<void>(rig.open(p, aad));
+    } catch (...) {
+        hit = true;
+    }
+    need(hit, "chacha tag tamper was not detected");
+
+    const auto picked = syncstream::pick_suite();
+    need(picked == syncstream::Suite::aes_gcm || picked == syncstream::Suite::chacha_poly, "picked suite invalid");
+    need(syncstream::pick_suite() == picked, "suite pick not stable");
+}
+
 void hex_flow() {
     std::array<std::uint8_t, 4> src{0xDE, 0xAD, 0xBE, 0xEF};
     const std::string text = syncstream::hex_of(src);
@@ -103,6 +137,7 @@ int main() {
         tamper_ciphertext_fails();
         tamper_aad_fails();
         tamper_tag_fails();
+        chacha_roundtrip();
         hex_flow();
         std::cout << "syncstream tests passed\n";
         return 0;
@@ -0,0 +1,67 @@
+#include "syncstream/secure_channel.hpp"
+#include "syncstream/secure_pool.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+void need(bool ok, const std::string& msg) {
+    if (!ok) {
+        throw std::runtime_error(msg);
+    }
+}
+
+void blocks_recycle_clean() {
+    syncstream::SecurePool pool;
+    auto* a = pool.grab(40);
+    need(a != nullptr, "grab failed");
+    need(std::all_of(a, a + 64, [](std::uint8_t b) { return b == 0; }), "fresh block not zeroed");
+    std::fill_n(a, 40, std::uint8_t{0xAB});
+    pool.give(a, 40);
+
+    auto* b = pool.grab(50);
+    need(b == a, "size class block not reused");
+    need(std::all_of(b, b + 64, [](std::uint8_t v) { return v == 0; }), "returned block not cleansed");
+    need(pool.stats().in_use == 1, "in-use count wrong");
+    pool.give(b, 50);
+
+    auto* big = pool.grab(syncstream::SecurePool::max_class + 1);
+    need(pool.stats().large == 1, "large block not tracked");
+    big[syncstream::SecurePool::max_class] = 1;
+    pool.give(big, syncstream::SecurePool::max_class + 1);
+    need(pool.stats().large == 0 && pool.stats().in_use == 0, "blocks leaked");
+}
+
+void blob_owns_pool_block() {
+    const auto before = syncstream::SecurePool::global().stats().in_use;
+    {
+        syncstream::SecureBlob blob(std::vector<std::uint8_t>{1, 2, 3});
+        need(blob.size() == 3 && blob.view()[2] == 3, "blob copy mismatch");
+        syncstream::SecureBlob moved(std::move(blob));
+        need(blob.size() == 0 && moved.view()[0] == 1, "blob move mismatch");
+        need(syncstream::SecurePool::global().stats().in_use == before + 1, "blob block not pooled");
+        const auto out = moved.take();
+        need(out == std::vector<std::uint8_t>({1, 2, 3}), "blob take mismatch");
+    }
+    need(syncstream::SecurePool::global().stats().in_use == before, "blob block not returned");
+}
+
+}
+
+int main() {
+    try {
+        blocks_recycle_clean();
+        blob_owns_pool_block();
+        std::cout << "secure pool tests passed\n";
+        return 0;
+    } catch (const std::exception& ex) {
+        std::cerr << ex.what() << '\n';
+        return 1;
+    }
+}
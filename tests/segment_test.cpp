@@ -0,0 +1,115 @@
+#include "syncstream/segment.hpp"
+
+#include <cstdint>
+#include <iostream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+void need(bool ok, const std::string& msg) {
+    if (!ok) {
+        throw std::runtime_error(msg);
+    }
+}
+
+std::vector<std::vector<std::uint8_t>> footage(std::size_t n) {
+    std::vector<std::vector<std::uint8_t>> out(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        out[i].assign(512 + i % 7, static_cast<std::uint8_t>(i * 31U));
+    }
+    return out;
+}
+
+std::vector<std::span<const std::uint8_t>> spans_of(const std::vector<std::vector<std::uint8_t>>& raw, std::size_t first, std::size_t count) {
+    std::vector<std::span<const std::uint8_t>> out;
+    for (std::size_t i = first; i < first + count; ++i) {
+        out.emplace_back(raw[i]);
+    }
+    return out;
+}
+
+void parallel_matches_serial() {
+    const auto raw = footage(1000);
+    const auto all = spans_of(raw, 0, raw.size());
+    const auto serial = syncstream::SegmentTree::build(all, 0, 1000, 1);
+    const auto wide = syncstream::SegmentTree::build(all, 0, 1000, 8);
+    need(serial.root() == wide.root(), "parallel root differs");
+}
+
+void every_range_verifies() {
+    syncstream::CipherRig rig(syncstream::mint_key());
+    for (std::size_t n : {1U, 2U, 3U, 5U, 8U, 13U}) {
+        const auto raw = footage(n);
+        const auto tree = syncstream::SegmentTree::build(spans_of(raw, 0, n), 10'000, 2000);
+        const auto seal = tree.seal(rig, 3);
+        for (std::size_t first = 0; first < n; ++first) {
+            for (std::size_t count = 1; first + count <= n; ++count) {
+                const auto proof = tree.prove_chunks(first, count);
+                need(syncstream::verify_range(seal, rig, spans_of(raw, first, count), proof), "valid range rejected");
+            }
+        }
+    }
+}
+
+void excerpt_is_small() {
+    syncstream::CipherRig rig(syncstream::mint_key());
+    const auto raw = footage(1800);
+    const auto t0 = 1'700'000'000'000ULL;
+    const auto tree = syncstream::SegmentTree::build(spans_of(raw, 0, raw.size()), t0, 2000);
+    const auto seal = tree.seal(rig, 1);
+
+    const auto proof = tree.prove(t0 + 600'000, t0 + 630'000);
+    need(proof.first == 300 && proof.count == 15, "time range mapped wrongly");
+    need(proof.nodes.size() <= 2 * 11, "proof not logarithmic");
+    need(syncstream::verify_range(seal, rig, spans_of(raw, 300, 15), proof), "excerpt rejected");
+}
+
+void tamper_rejected() {
+    syncstream::CipherRig rig(syncstream::mint_key());
+    auto raw = footage(64);
+    const auto tree = syncstream::SegmentTree::build(spans_of(raw, 0, raw.size()), 0, 1000);
+    const auto seal = tree.seal(rig, 1);
+    const auto proof = tree.prove_chunks(10, 4);
+
+    raw[11][5] ^= 0x01U;
+    need(!syncstream::verify_range(seal, rig, spans_of(raw, 10, 4), proof), "edited chunk accepted");
+    raw[11][5] ^= 0x01U;
+
+    auto moved = proof;
+    moved.first = 12;
+    need(!syncstream::verify_range(seal, rig, spans_of(raw, 10, 4), moved), "shifted range accepted");
+
+    auto bad_seal = seal;
+    bad_seal.start_ms += 1;
+    need(!syncstream::verify_range(bad_seal, rig, spans_of(raw, 10, 4), proof), "altered seal metadata accepted");
+
+    syncstream::CipherRig other(syncstream::mint_key());
+    need(!syncstream::verify_range(seal, other, spans_of(raw, 10, 4), proof), "root accepted under wrong key");
+
+    bool hit = false;
+    try {
+        static_cast<void>(tree.prove(0, 65'000 + 1));
+    } catch (...) {
+        hit = true;
+    }
+    need(hit, "range past segment end accepted");
+}
+
+}
+
+int main() {
+    try {
+        parallel_matches_serial();
+        every_range_verifies();
+        excerpt_is_small();
+        tamper_rejected();
+        std::cout << "segment tests passed\n";
+        return 0;
+    } catch (const std::exception& ex) {
+        std::cerr << ex.what() << '\n';
+        return 1;
+    }
+}
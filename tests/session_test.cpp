@@ -0,0 +1,172 @@
+#include "syncstream/session.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+void need(bool ok, const std::string& msg) {
+    if (!ok) {
+        throw std::runtime_error(msg);
+    }
+}
+
+struct Site {
+    std::array<std::uint8_t, syncstream::key_len> master = syncstream::mint_key();
+    syncstream::Keychain relay{master};
+    syncstream::Keychain cam{master};
+
+    Site() {
+        const std::vector<std::uint8_t> salt{1, 2, 3};
+        const std::vector<std::uint8_t> ctx{'s', 'e', 's', 's'};
+        relay.stage(1, salt, ctx);
+        relay.activate(1);
+        cam.stage(1, salt, ctx);
+        cam.activate(1);
+    }
+};
+
+bool same(const syncstream::SecureBlob& a, const syncstream::SecureBlob& b) {
+    return std::ranges::equal(a.view(), b.view());
+}
+
+void full_then_resume() {
+    Site site;
+    need(site.relay.suite(1) == syncstream::Suite::aes_gcm, "default suite not deterministic");
+    auto clock = std::make_shared<syncstream::ManualClock>(1'700'000'000'000ULL);
+    syncstream::SessionGate gate(site.relay, std::chrono::minutes(10), clock);
+    syncstream::SessionClient cam(site.cam, "cam-door");
+
+    need(!cam.can_resume(), "fresh client has ticket");
+    auto first = gate.accept(cam.hello());
+    need(!first.welcome.resumed, "first handshake resumed");
+    need(same(cam.finish(first.welcome), first.key), "full handshake keys differ");
+    need(cam.can_resume(), "ticket not stored");
+
+    clock->advance(std::chrono::seconds(5));
+    auto second = gate.accept(cam.hello());
+    need(second.welcome.resumed, "reconnect did not resume");
+    need(same(cam.finish(second.welcome), second.key), "resumed keys differ");
+    need(!same(first.key, second.key), "resumed key reused");
+
+    const auto stats = gate.stats();
+    need(stats.full == 1 && stats.resumed == 1 && stats.rejected == 0, "session stats mismatch");
+}
+
+void ticket_single_use() {
+    Site site;
+    auto clock = std::make_shared<syncstream::ManualClock>(1'700'000'000'000ULL);
+    syncstream::SessionGate gate(site.relay, std::chrono::minutes(10), clock);
+    syncstream::SessionClient cam(site.cam, "cam-yard");
+    static_cast<void>(cam.finish(gate.accept(cam.hello()).welcome));
+
+    const auto hello = cam.hello();
+    need(gate.accept(hello).welcome.resumed, "first redemption failed");
+    const auto again = gate.accept(hello);
+    need(!again.welcome.resumed, "ticket redeemed twice");
+    need(gate.stats().rejected == 1, "reuse not counted");
+}
+
+void ticket_tamper_and_expiry() {
+    Site site;
+    auto clock = std::make_shared<syncstream::ManualClock>(1'700'000'000'000ULL);
+    syncstream::SessionGate gate(site.relay, std::chrono::seconds(30), clock);
+    syncstream::SessionClient cam(site.cam, "cam-gate");
+    static_cast<void>(cam.finish(gate.accept(cam.hello()).welcome));
+
+    auto bad = cam.hello();
+    bad.ticket->pkt.body[0] ^= 0x01U;
+    need(!gate.accept(bad).welcome.resumed, "tampered ticket accepted");
+
+    auto stolen = cam.hello();
+    stolen.dev = "cam-other";
+    need(!gate.accept(stolen).welcome.resumed, "ticket accepted for other device");
+
+    clock->advance(std::chrono::seconds(31));
+    auto late = gate.accept(cam.hello());
+    need(!late.welcome.resumed, "expired ticket accepted");
+    need(same(cam.finish(late.welcome), late.key), "fallback handshake keys differ");
+}
+
+void wrong_psk_rejected() {
+    Site site;
+    syncstream::Keychain rogue(syncstream::mint_key());
+    rogue.stage(1, std::vector<std::uint8_t>{1, 2, 3}, std::vector<std::uint8_t>{'s', 'e', 's', 's'});
+    rogue.activate(1);
+
+    syncstream::SessionGate gate(site.relay, std::chrono::minutes(10));
+    syncstream::SessionClient cam(rogue, "cam-rogue");
+    const auto out = gate.accept(cam.hello());
+
+    bool hit = false;
+    try {
+        static_cast<void>(cam.finish(out.welcome));
+    } catch (...) {
+        hit = true;
+    }
+    need(hit, "proof accepted without shared key");
+    need(!cam.can_resume(), "ticket kept after failed proof");
+}
+
+void ticket_survives_rotation() {
+    Site site;
+    syncstream::SessionGate gate(site.relay, std::chrono::minutes(10));
+    syncstream::SessionClient cam(site.cam, "cam-rot");
+    static_cast<void>(cam.finish(gate.accept(cam.hello()).welcome));
+
+    site.relay.stage(2, std::vector<std::uint8_t>{4}, std::vector<std::uint8_t>{'v', '2'}, syncstream::Suite::chacha_poly);
+    site.relay.activate(2);
+    auto out = gate.accept(cam.hello());
+    need(out.welcome.resumed, "ticket from previous version rejected");
+    need(out.welcome.ticket.key_ver == 2, "new ticket not under active version");
+    need(same(cam.finish(out.welcome), out.key), "rotated resume keys differ");
+}
+
+void dropped_version_leaves_cache() {
+    Site site;
+    syncstream::SessionGate gate(site.relay, std::chrono::minutes(10));
+    syncstream::SessionClient cam(site.cam, "cam-drop");
+    static_cast<void>(cam.finish(gate.accept(cam.hello()).welcome));
+    need(gate.cached_rigs() == 1, "ticket rig not cached");
+
+    const auto rotate = [&](std::uint32_t ver) {
+        for (auto* keys : {&site.relay, &site.cam}) {
+            keys->stage(ver, std::vector<std::uint8_t>{static_cast<std::uint8_t>(ver)}, std::vector<std::uint8_t>{'r', 'o', 't'});
+            keys->activate(ver);
+            keys->drop(ver - 1);
+        }
+    };
+    rotate(2);
+    const auto out = gate.accept(cam.hello());
+    need(!out.welcome.resumed, "ticket under dropped version resumed");
+    need(gate.cached_rigs() == 1 && out.welcome.ticket.key_ver == 2, "dropped rig kept in cache");
+
+    rotate(3);
+    syncstream::SessionClient fresh(site.cam, "cam-fresh");
+    static_cast<void>(gate.accept(fresh.hello()));
+    need(gate.cached_rigs() == 1, "rig for retired version survived rotation");
+}
+}
+
+int main() {
+    try {
+        full_then_resume();
+        ticket_single_use();
+        ticket_tamper_and_expiry();
+        wrong_psk_rejected();
+        ticket_survives_rotation();
+        dropped_version_leaves_cache();
+        std::cout << "session tests passed\n";
+        return 0;
+    } catch (const std::exception& ex) {
+        std::cerr << ex.what() << '\n';
+        return 1;
+    }
+}
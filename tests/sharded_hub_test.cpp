@@ -0,0 +1,153 @@
+#include "syncstream/sharded_hub.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+void need(bool ok, const std::string& msg) {
+    if (!ok) {
+        throw std::runtime_error(msg);
+    }
+}
+
+std::vector<syncstream::Opened> collect(syncstream::ShardedHub& hub, std::size_t want) {
+    std::vector<syncstream::Opened> out;
+    const auto until = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (out.size() < want && std::chrono::steady_clock::now() < until) {
+        if (hub.poll(out) == 0) {
+            std::this_thread::yield();
+        }
+    }
+    return out;
+}
+
+void ring_order() {
+    syncstream::SpscRing<int> ring(3);
+    need(ring.capacity() == 4, "ring not rounded up");
+    for (int i = 0; i < 4; ++i) {
+        need(ring.push(int(i)), "ring refused item");
+    }
+    need(!ring.push(9), "full ring accepted item");
+    int v = -1;
+    need(ring.pop(v) && v == 0, "ring order wrong");
+    need(ring.push(4), "ring did not free slot");
+    for (int i = 1; i <= 4; ++i) {
+        need(ring.pop(v) && v == i, "ring wrap order wrong");
+    }
+    need(!ring.pop(v) && ring.empty(), "empty ring returned item");
+}
+
+void spread_and_open() {
+    const auto master = syncstream::mint_key();
+    syncstream::EdgeHub tx(master, std::chrono::seconds(30), 4096, 1000, 1000);
+    syncstream::ShardedHub rx(master, std::chrono::seconds(30), 4096, 1000, 1000, 4, 256, false);
+    const std::vector<std::uint8_t> s{1};
+    const std::vector<std::uint8_t> c{2};
+    tx.stage_key(1, s, c, true);
+    tx.allow_cmd(syncstream::Cmd::ping);
+    rx.stage_key(1, s, c, true);
+    rx.allow_cmd(syncstream::Cmd::ping);
+
+    std::map<std::uint64_t, std::string> sent;
+    std::uint64_t tag = 0;
+    for (int d = 0; d < 32; ++d) {
+        const auto dev = "cam-" + std::to_string(d);
+        for (int k = 0; k < 8; ++k) {
+            const auto env = tx.seal({dev, syncstream::Cmd::ping, syncstream::now_ms(), {}});
+            while (!rx.submit(tag, dev, env)) {
+                std::this_thread::yield();
+            }
+            sent[tag++] = dev;
+        }
+    }
+
+    const auto out = collect(rx, sent.size());
+    need(out.size() == sent.size(), "results missing");
+    for (const auto& res : out) {
+        need(res.ctrl && res.err.empty(), "open failed on shard: " + res.err);
+        need(res.ctrl->dev.str() == sent.at(res.tag), "result tag mismatch");
+    }
+
+    std::uint64_t total = 0;
+    std::size_t busy = 0;
+    for (std::size_t i = 0; i < rx.shards(); ++i) {
+        total += rx.handled(i);
+        busy += rx.handled(i) > 0 ? 1 : 0;
+    }
+    need(total == sent.size() && busy > 1, "work not spread across shards");
+}
+
+void hint_and_replay_checked() {
+    const auto master = syncstream::mint_key();
+    syncstream::EdgeHub tx(master, std::chrono::seconds(30), 4096, 1000, 1000);
+    syncstream::ShardedHub rx(master, std::chrono::seconds(30), 4096, 1000, 1000, 8, 64, false);
+    const std::vector<std::uint8_t> s{1};
+    const std::vector<std::uint8_t> c{2};
+    tx.stage_key(1, s, c, true);
+    tx.allow_cmd(syncstream::Cmd::arm);
+    rx.stage_key(1, s, c, true);
+    rx.allow_cmd(syncstream::Cmd::arm);
+
+    const auto env = tx.seal({"cam-door", syncstream::Cmd::arm, syncstream::now_ms(), {1}});
+    need(rx.submit(1, "cam-door", env), "submit refused");
+    auto out = collect(rx, 1);
+    need(out.size() == 1 && out[0].ctrl, "first open failed");
+
+    need(rx.submit(2, "cam-door", env), "submit refused");
+    out = collect(rx, 1);
+    need(out.size() == 1 && !out[0].ctrl && out[0].err == "replay blocked", "replay passed on shard");
+
+    const auto other = tx.seal({"cam-door", syncstream::Cmd::arm, syncstream::now_ms(), {2}});
+    std::string lie = "cam-x";
+    for (int i = 0; rx.shard_of(lie) == rx.shard_of("cam-door"); ++i) {
+        lie = "cam-x" + std::to_string(i);
+    }
+    need(rx.submit(3, lie, other), "submit refused");
+    out = collect(rx, 1);
+    need(out.size() == 1 && out[0].err == "shard hint mismatch", "wrong hint accepted");
+}
+
+void overlap_passed_to_shards() {
+    const auto master = syncstream::mint_key();
+    syncstream::EdgeHub tx(master, std::chrono::seconds(30), 4096, 1000, 1000);
+    syncstream::ShardedHub rx(master, std::chrono::seconds(30), 4096, 1000, 1000, 2, 64, false, std::chrono::milliseconds(0));
+    const std::vector<std::uint8_t> s1{1};
+    const std::vector<std::uint8_t> c1{'v', '1'};
+    const std::vector<std::uint8_t> s2{2};
+    const std::vector<std::uint8_t> c2{'v', '2'};
+    tx.stage_key(1, s1, c1, true);
+    tx.allow_cmd(syncstream::Cmd::ping);
+    rx.stage_key(1, s1, c1, true);
+    rx.stage_key(2, s2, c2, false);
+    rx.allow_cmd(syncstream::Cmd::ping);
+
+    const auto env = tx.seal({"cam-rot", syncstream::Cmd::ping, syncstream::now_ms(), {}});
+    rx.activate_key(2);
+    need(rx.submit(1, "cam-rot", env), "submit refused");
+    const auto out = collect(rx, 1);
+    need(out.size() == 1 && !out[0].ctrl, "retired version opened without overlap");
+}
+
+}
+
+int main() {
+    try {
+        ring_order();
+        spread_and_open();
+        hint_and_replay_checked();
+        overlap_passed_to_shards();
+        std::cout << "sharded hub tests passed\n";
+        return 0;
+    } catch (const std::exception& ex) {
+        std::cerr << ex.what() << '\n';
+        return 1;
+    }
+}
@@ -0,0 +1,126 @@
+#include "syncstream/middleware.hpp"
+#include "syncstream/shm_replay.hpp"
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+void need(bool ok, const std::string& msg) {
+    if (!ok) {
+        throw std::runtime_error(msg);
+    }
+}
+
+std::string shm_name(const char* tag) {
+    return std::string("/syncstream-test-") + tag + "-" + std::to_string(getpid());
+}
+
+void shared_between_attachments() {
+    const auto name = shm_name("attach");
+    syncstream::ShmReplay::unlink(name);
+    const auto key = syncstream::mint_key();
+    const std::uint64_t t0 = 1'700'000'000'000ULL;
+    auto clock = std::make_shared<syncstream::ManualClock>(t0);
+    auto a = std::make_shared<syncstream::ShmReplay>(name, 4096, std::chrono::seconds(4));
+    auto b = std::make_shared<syncstream::ShmReplay>(name, 4096, std::chrono::seconds(4));
+
+    syncstream::RelayCore tx(key, std::chrono::seconds(4), 64, clock);
+    syncstream::RelayCore rx_a(key, std::chrono::seconds(4), a, clock);
+    syncstream::RelayCore rx_b(key, std::chrono::seconds(4), b, clock);
+
+    syncstream::Ctrl c{"cam-shm", syncstream::Cmd::arm, t0, {1}};
+    const auto env = tx.seal_ctrl(c);
+    static_cast<void>(rx_a.open_ctrl(env));
+
+    bool hit = false;
+    try {
+        static_cast<void>(rx_b.open_ctrl(env));
+    } catch (...) {
+        hit = true;
+    }
+    need(hit, "replay not shared across attachments");
+    need(b->size(t0) == 1, "shared entry count wrong");
+
+    clock->advance(std::chrono::seconds(6));
+    need(b->size(clock->now_ms()) == 0, "entry did not age out");
+    syncstream::ShmReplay::unlink(name);
+}
+
+void window_must_cover_skew() {
+    const auto name = shm_name("narrow");
+    syncstream::ShmReplay::unlink(name);
+    auto narrow = std::make_shared<syncstream::ShmReplay>(name, 256, std::chrono::seconds(1));
+    need(narrow->window() == 1000, "window accessor wrong");
+    bool hit = false;
+    try {
+        syncstream::RelayCore rx(syncstream::mint_key(), std::chrono::seconds(4), narrow);
+    } catch (const std::exception&) {
+        hit = true;
+    }
+    need(hit, "replay window shorter than skew accepted");
+    syncstream::ShmReplay::unlink(name);
+}
+
+void neighbour_epochs_probed() {
+    const auto name = shm_name("nbr");
+    syncstream::ShmReplay::unlink(name);
+    syncstream::ShmReplay table(name, 1024, std::chrono::seconds(2));
+    const auto span = syncstream::replay_span(std::chrono::seconds(2));
+    const std::uint64_t now = 1'700'000'000'000ULL;
+    const std::uint64_t at = now / span * span;
+
+    syncstream::Packet pkt{};
+    pkt.nonce[1] = 3;
+    const auto key = syncstream::ReplayKey::of(9, pkt);
+    need(!table.seen_or_mark(key, at, now), "fresh key flagged");
+    need(table.seen_or_mark(key, at + span, now), "later epoch missed replay");
+    need(table.seen_or_mark(key, at - 1, now), "earlier epoch missed replay");
+    need(table.size(now) == 1, "neighbour probe inserted");
+    syncstream::ShmReplay::unlink(name);
+}
+
+void shared_across_fork() {
+    const auto name = shm_name("fork");
+    syncstream::ShmReplay::unlink(name);
+    syncstream::ShmReplay table(name, 1024, std::chrono::seconds(2));
+    const std::uint64_t now = 1'700'000'000'000ULL;
+
+    syncstream::Packet pkt{};
+    pkt.nonce[0] = 7;
+    pkt.mac[3] = 9;
+    const auto key = syncstream::ReplayKey::of(42, pkt);
+
+    const pid_t pid = fork();
+    if (pid == 0) {
+        syncstream::ShmReplay child(name, 1024, std::chrono::seconds(2));
+        _exit(child.seen_or_mark(key, now, now) ? 1 : 0);
+    }
+    int status = 0;
+    need(waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0, "child insert failed");
+    need(table.seen_or_mark(key, now, now), "child entry not visible to parent");
+    syncstream::ShmReplay::unlink(name);
+}
+
+}
+
+int main() {
+    try {
+        shared_between_attachments();
+        window_must_cover_skew();
+        neighbour_epochs_probed();
+        shared_across_fork();
+        std::cout << "shm replay tests passed\n";
+        return 0;
+    } catch (const std::exception& ex) {
+        std::cerr << ex.what() << '\n';
+        return 1;
+    }
+}
@@ -0,0 +1,195 @@
+#include "syncstream/sync_state.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+const syncstream::SyncBody hd{syncstream::Res::p1080, 30, 4000, 60, false, true};
+
+void need(bool ok, const std::string& msg) {
+    if (!ok) {
+        throw std::runtime_error(msg);
+    }
+}
+
+void delta_codec() {
+    auto next = hd;
+    next.fps = 15;
+    const auto one = syncstream::encode_delta(&hd, next);
+    need(one.size() == 2 && one[0] == 0b10 && one[1] == 15, "single field delta wrong");
+    need(syncstream::encode_delta(&hd, hd).size() == 1, "empty delta not minimal");
+    const auto full = syncstream::encode_delta<syncstream::SyncBody>(nullptr, next);
+    need(full.size() == 1 + syncstream::wire_size_v<syncstream::SyncBody>, "full body size wrong");
+
+    auto cfg = hd;
+    need(syncstream::apply_delta(cfg, one, false) && cfg == next, "delta not applied");
+    syncstream::SyncBody blank{};
+    need(!syncstream::apply_delta(blank, one, true), "partial body taken as full");
+    need(syncstream::apply_delta(blank, full, true) && blank == next, "full body not applied");
+
+    auto bad = one;
+    bad[0] = 0x80;
+    need(!syncstream::apply_delta(cfg, bad, false), "unknown field bit accepted");
+    bad = one;
+    bad.push_back(0);
+    need(!syncstream::apply_delta(cfg, bad, false), "trailing delta bytes accepted");
+    bad = one;
+    bad[1] = 0;
+    need(!syncstream::apply_delta(cfg, bad, false), "invalid field value accepted");
+}
+
+struct Link {
+    syncstream::RelayCore relay;
+    syncstream::RelayCore cam;
+    syncstream::AckWindow acks{std::chrono::milliseconds(10), 1};
+    std::unique_ptr<syncstream::SyncSender> sender = std::make_unique<syncstream::SyncSender>();
+    std::unique_ptr<syncstream::SyncMirror> mirror = std::make_unique<syncstream::SyncMirror>(4);
+
+    explicit Link(const std::array<std::uint8_t, syncstream::key_len>& key)
+        : relay(key, std::chrono::seconds(30)), cam(key, std::chrono::seconds(30)) {}
+
+    std::pair<syncstream::SyncOut, syncstream::SyncApply> push(const syncstream::SyncBody& cfg, std::uint64_t now, bool ack = true) {
+        auto out = sender->stage("cam-3", cfg, now);
+        const syncstream::VersionedEnv env{1, relay.seal_ctrl(out.ctrl)};
+        sender->sent("cam-3", out.ver, env);
+        const auto view = cam.open_view(env.env, now);
+        const auto res = mirror->apply(view.body());
+        if (ack && res == syncstream::SyncApply::applied) {
+            acks.note(view.dev(), env.key_ver, env.env.seq, now);
+            for (const auto& a : acks.due(now)) {
+                sender->on_ack(a.dev.str(), syncstream::unpack_ack(a.body.view()));
+            }
+        }
+        return {std::move(out), res};
+    }
+};
+
+void acked_base_drives_deltas() {
+    Link link(syncstream::mint_key());
+    const auto now = syncstream::now_ms();
+
+    auto [first, r1] = link.push(hd, now);
+    need(first.full && r1 == syncstream::SyncApply::applied, "first sync not full");
+    need(link.sender->base("cam-3") == 1U, "ack did not set base");
+
+    auto cfg = hd;
+    cfg.night = true;
+    auto [second, r2] = link.push(cfg, now);
+    need(!second.full && r2 == syncstream::SyncApply::applied, "second sync not delta");
+    need(second.ctrl.body.size() < first.ctrl.body.size() / 2, "delta not compact");
+    need(link.mirror->current()->second == cfg, "mirror out of step");
+
+    cfg.fps = 25;
+    auto [third, r3] = link.push(cfg, now, false);
+    cfg.bitrate_kbps = 2500;
+    auto [fourth, r4] = link.push(cfg, now, false);
+    need(r3 == syncstream::SyncApply::applied && r4 == syncstream::SyncApply::applied, "unacked deltas refused");
+    need(link.mirror->current()->first == 4 && link.mirror->current()->second == cfg, "stacked deltas wrong");
+
+    syncstream::SyncMirror late(4);
+    need(late.apply(first.ctrl.body.view()) == syncstream::SyncApply::applied, "late full refused");
+    need(late.apply(fourth.ctrl.body.view()) == syncstream::SyncApply::diverged, "missing base not detected");
+    need(late.apply(second.ctrl.body.view()) == syncstream::SyncApply::applied, "acked delta refused");
+    need(late.apply(fourth.ctrl.body.view()) == syncstream::SyncApply::applied, "delta against older base refused");
+    need(late.apply(third.ctrl.body.view()) == syncstream::SyncApply::stale, "reordered delta applied");
+    need(late.current()->second == cfg, "reordered mirror wrong");
+}
+
+void divergence_falls_back_to_full() {
+    Link link(syncstream::mint_key());
+    const auto now = syncstream::now_ms();
+    static_cast<void>(link.push(hd, now));
+
+    link.mirror = std::make_unique<syncstream::SyncMirror>(4);
+    auto cfg = hd;
+    cfg.res = syncstream::Res::p720;
+    auto [delta, res] = link.push(cfg, now);
+    need(!delta.full && res == syncstream::SyncApply::diverged, "divergence not detected");
+
+    link.sender->reset("cam-3");
+    auto [full, again] = link.push(cfg, now);
+    need(full.full && again == syncstream::SyncApply::applied, "reset did not send full body");
+    need(link.mirror->current()->second == cfg && link.sender->base("cam-3") == full.ver, "recovery incomplete");
+
+    bool hit = false;
+    try {
+        static_cast<void>(link.mirror->apply(std::vector<std::uint8_t>{0, 0, 0, 9, 1}));
+    } catch (const std::exception&) {
+        hit = true;
+    }
+    need(hit, "truncated sync accepted");
+}
+
+void restart_resyncs_with_full_body() {
+    Link link(syncstream::mint_key());
+    const auto now = syncstream::now_ms();
+    auto cfg = hd;
+    for (std::uint8_t fps = 10; fps < 14; ++fps) {
+        cfg.fps = fps;
+        static_cast<void>(link.push(cfg, now));
+    }
+    need(link.mirror->current()->first == 4, "mirror not at version four");
+    const auto replayed = link.sender->stage("cam-3", cfg, now);
+
+    link.sender->reset("cam-3");
+    need(link.sender->staged("cam-3") == 0, "reset kept staged configs");
+    link.sender = std::make_unique<syncstream::SyncSender>();
+    cfg.night = true;
+    auto [full, res] = link.push(cfg, now);
+    need(full.full && full.ver == 1 && res == syncstream::SyncApply::applied, "restarted sender stuck stale");
+    need(link.mirror->current()->first == 1 && link.mirror->current()->second == cfg, "resync not adopted");
+    need(link.mirror->apply(full.ctrl.body.view()) == syncstream::SyncApply::stale, "duplicate full reapplied");
+    need(link.mirror->apply(replayed.ctrl.body.view()) == syncstream::SyncApply::diverged, "pre-restart delta applied");
+
+    cfg.gop = 30;
+    auto [delta, again] = link.push(cfg, now);
+    need(!delta.full && again == syncstream::SyncApply::applied, "delta after resync refused");
+}
+
+void lost_envelopes_pruned() {
+    Link link(syncstream::mint_key());
+    const auto now = syncstream::now_ms();
+    static_cast<void>(link.push(hd, now));
+
+    syncstream::RetryBook book(std::chrono::milliseconds(10), std::chrono::milliseconds(30));
+    auto cfg = hd;
+    for (std::uint8_t fps = 20; fps < 23; ++fps) {
+        cfg.fps = fps;
+        auto out = link.sender->stage("cam-3", cfg, now);
+        const syncstream::VersionedEnv env{1, link.relay.seal_ctrl(out.ctrl)};
+        link.sender->sent("cam-3", out.ver, env);
+        book.track("cam-3", env, now);
+    }
+    need(link.sender->staged("cam-3") == 3, "unacked configs not staged");
+    const auto plan = book.due(now + 100);
+    need(plan.lost.size() == 3, "envelopes not reported lost");
+    link.sender->lost(plan.lost[0].dev.str(), plan.lost[0].env);
+    need(link.sender->staged("cam-3") == 2, "lost config kept");
+    for (const auto& r : plan.lost) {
+        link.sender->lost(r.dev.str(), r.env);
+    }
+    need(link.sender->staged("cam-3") == 0 && link.sender->base("cam-3") == 1U, "lost configs leaked");
+}
+
+}
+
+int main() {
+    try {
+        delta_codec();
+        acked_base_drives_deltas();
+        divergence_falls_back_to_full();
+        restart_resyncs_with_full_body();
+        lost_envelopes_pruned();
+        std::cout << "sync state tests passed\n";
+        return 0;
+    } catch (const std::exception& ex) {
+        std::cerr << ex.what() << '\n';
+        return 1;
+    }
+}
@@ -0,0 +1,158 @@
+#include "syncstream/tenant_hub.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+void need(bool ok, const std::string& msg) {
+    if (!ok) {
+        throw std::runtime_error(msg);
+    }
+}
+
+template <typename F>
+bool throws(F&& fn) {
+    try {
+        fn();
+    } catch (...) {
+        return true;
+    }
+    return false;
+}
+
+const std::vector<std::uint8_t> salt{1};
+const std::vector<std::uint8_t> ctx{2};
+
+void isolated_tenants() {
+    syncstream::TenantHub hub(std::chrono::seconds(30), 1 << 20);
+    hub.add_tenant("acme", syncstream::mint_key());
+    hub.add_tenant("globex", syncstream::mint_key());
+    for (const auto* id : {"acme", "globex"}) {
+        hub.stage_key(id, 1, salt, ctx, true);
+        hub.allow_cmd(id, syncstream::Cmd::ping);
+    }
+    hub.allow_cmd("acme", syncstream::Cmd::arm);
+
+    const syncstream::Ctrl c{"cam-1", syncstream::Cmd::ping, syncstream::now_ms(), {}};
+    const auto env = hub.seal("acme", c);
+    need(hub.open("acme", env).dev.str() == "cam-1", "tenant open failed");
+    need(throws([&] { static_cast<void>(hub.open("acme", env)); }), "replay passed within tenant");
+    need(throws([&] { static_cast<void>(hub.open("globex", hub.seal("acme", c))); }), "envelope crossed tenants");
+    need(throws([&] { static_cast<void>(hub.seal("globex", {"cam-1", syncstream::Cmd::arm, syncstream::now_ms(), {}})); }), "tenant policy leaked");
+    need(throws([&] { static_cast<void>(hub.open("initech", env)); }), "unknown tenant accepted");
+}
+
+void lazy_and_accounted() {
+    syncstream::TenantHub hub(std::chrono::seconds(30), 64 << 20);
+    syncstream::TenantConfig cfg{};
+    cfg.burst = 1000;
+    cfg.refill_per_sec = 1000;
+    for (int i = 0; i < 2000; ++i) {
+        const auto id = "t-" + std::to_string(i);
+        hub.add_tenant(id, syncstream::mint_key(), cfg);
+        hub.stage_key(id, 1, salt, ctx, true);
+        hub.allow_cmd(id, syncstream::Cmd::ping);
+    }
+    need(hub.tenants() == 2000 && hub.reserved() == 2000 * cfg.max_bytes, "reservation wrong");
+
+    const auto idle = hub.usage("t-5");
+    need(idle.cores == 0 && idle.replay == 0 && idle.devices == 0, "idle tenant allocated state");
+
+    for (int i = 0; i < 10; ++i) {
+        static_cast<void>(hub.open("t-5", hub.seal("t-5", {"cam-" + std::to_string(i), syncstream::Cmd::ping, syncstream::now_ms(), {}})));
+    }
+    const auto busy = hub.usage("t-5");
+    need(busy.cores == 1 && busy.replay == 10 && busy.devices == 10, "usage not tracked");
+    need(busy.bytes > idle.bytes && busy.bytes <= busy.limit, "usage bytes wrong");
+    need(hub.usage("t-6").cores == 0, "neighbour tenant grew");
+}
+
+void limits_enforced() {
+    syncstream::TenantConfig cfg{};
+    cfg.max_bytes = 8 * 1024;
+    syncstream::TenantHub hub(std::chrono::seconds(30), 3 * cfg.max_bytes);
+    hub.add_tenant("a", syncstream::mint_key(), cfg);
+    hub.add_tenant("b", syncstream::mint_key(), cfg);
+    hub.add_tenant("c", syncstream::mint_key(), cfg);
+    need(throws([&] { hub.add_tenant("d", syncstream::mint_key(), cfg); }), "budget overcommitted");
+    need(throws([&] { hub.add_tenant("a", syncstream::mint_key(), cfg); }), "duplicate tenant accepted");
+    hub.drop_tenant("c");
+    hub.add_tenant("d", syncstream::mint_key(), cfg);
+
+    cfg.burst = 100000;
+    cfg.refill_per_sec = 100000;
+    hub.drop_tenant("d");
+    hub.add_tenant("d", syncstream::mint_key(), cfg);
+    hub.stage_key("d", 1, salt, ctx, true);
+    hub.allow_cmd("d", syncstream::Cmd::ping);
+    bool capped = false;
+    for (int i = 0; i < 1000 && !capped; ++i) {
+        try {
+            static_cast<void>(hub.open("d", hub.seal("d", {"cam-" + std::to_string(i), syncstream::Cmd::ping, syncstream::now_ms(), {}})));
+        } catch (const std::exception& ex) {
+            capped = std::string(ex.what()) == "tenant memory limit";
+        }
+    }
+    need(capped, "tenant grew past its limit");
+    need(hub.usage("d").bytes <= cfg.max_bytes, "usage above limit");
+}
+
+void tenant_keys_retire() {
+    auto clock = std::make_shared<syncstream::ManualClock>(1'700'000'000'000ULL);
+    syncstream::TenantHub hub(std::chrono::seconds(30), 1 << 20, std::chrono::seconds(10), clock);
+    hub.add_tenant("acme", syncstream::mint_key());
+    hub.allow_cmd("acme", syncstream::Cmd::ping);
+    hub.stage_key("acme", 1, salt, ctx, true);
+    const auto old = hub.seal("acme", {"cam-r", syncstream::Cmd::ping, clock->now_ms(), {}});
+    hub.stage_key("acme", 2, salt, ctx, false);
+    hub.stage_key("acme", 3, salt, ctx, true);
+    need(throws([&] { hub.stage_key("acme", 3, salt, ctx, false); }), "live version re-staged");
+
+    clock->advance(std::chrono::seconds(11));
+    need(throws([&] { static_cast<void>(hub.open("acme", old)); }), "retired version still opens");
+    need(hub.seal("acme", {"cam-r", syncstream::Cmd::ping, clock->now_ms(), {}}).key_ver == 3, "live version lost");
+    need(throws([&] { hub.activate_key("acme", 2); }), "skipped version never retired");
+}
+
+void device_turnover_stays_open() {
+    auto clock = std::make_shared<syncstream::ManualClock>(1'700'000'000'000ULL);
+    syncstream::TenantHub hub(std::chrono::seconds(1), 1 << 20, std::chrono::seconds(10), clock);
+    syncstream::TenantConfig cfg{};
+    cfg.max_bytes = 8 * 1024;
+    cfg.rate_idle = std::chrono::seconds(2);
+    hub.add_tenant("fleet", syncstream::mint_key(), cfg);
+    hub.stage_key("fleet", 1, salt, ctx, true);
+    hub.allow_cmd("fleet", syncstream::Cmd::ping);
+    for (int round = 0; round < 40; ++round) {
+        for (int i = 0; i < 10; ++i) {
+            const auto env = hub.seal("fleet", {"cam-" + std::to_string(round * 10 + i), syncstream::Cmd::ping, clock->now_ms(), {}});
+            static_cast<void>(hub.open("fleet", env));
+        }
+        clock->advance(std::chrono::seconds(5));
+    }
+    const auto use = hub.usage("fleet");
+    need(use.devices <= 10 && use.bytes <= use.limit, "idle devices never expired");
+}
+
+}
+
+int main() {
+    try {
+        isolated_tenants();
+        lazy_and_accounted();
+        limits_enforced();
+        tenant_keys_retire();
+        device_turnover_stays_open();
+        std::cout << "tenant hub tests passed\n";
+        return 0;
+    } catch (const std::exception& ex) {
+        std::cerr << ex.what() << '\n';
+        return 1;
+    }
+}